@@ -16,4 +16,10 @@
 // -logtypes <Logger::Type>
 #define CLO_LOG_TYPES               "-lt"
 
+// -logflush <Flush interval in msecs, 0 - write synchronously>
+#define CLO_LOG_FLUSH_INTERVAL      "-lf"
+
+// -logsize <Max log file size in KBytes, 0 - unlimited>
+#define CLO_LOG_MAX_FILE_SIZE       "-ls"
+
 #endif //DEF_COMMANDLINE_H
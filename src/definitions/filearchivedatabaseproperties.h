@@ -5,5 +5,6 @@
 #define FADP_COMPATIBLE_VERSION               "CompatibleVersion"
 #define FADP_LAST_SYNC_TIME                   "LastSyncTime"
 #define FADP_DATABASE_NOT_CLOSED              "DatabaseNotClosed"
+#define FADP_TEXT_INDEX_READY                 "TextIndexReady"
 
 #endif // DEF_FILEARCHIVEDATABASEPROPERTIES_H
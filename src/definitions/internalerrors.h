@@ -39,7 +39,9 @@
 // FileStreamsManager
 #define IERR_FILESTREAMS_STREAM_FILE_IO_ERROR                "filestreams-stream-file-io-error"
 #define IERR_FILESTREAMS_STREAM_FILE_SIZE_CHANGED            "filestreams-stream-file-size-changed"
+#define IERR_FILESTREAMS_STREAM_FILE_HASH_MISMATCH           "filestreams-stream-file-hash-mismatch"
 #define IERR_FILESTREAMS_STREAM_CONNECTION_TIMEOUT           "filestreams-stream-connection-timeout"
+#define IERR_FILESTREAMS_STREAM_REQUEST_NOT_SENT             "filestreams-stream-request-not-sent"
 #define IERR_FILESTREAMS_STREAM_TERMINATED_BY_REMOTE_USER    "filestreams-stream-terminated-by-remote-user"
 
 // FileTransfer
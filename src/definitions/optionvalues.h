@@ -31,6 +31,7 @@
 #define OPV_ACCOUNT_IGNOREAUTOJOIN                      "accounts.account.ignore-autojoin"
 // Compress
 #define OPV_ACCOUNT_STREAMCOMPRESS                      "accounts.account.stream-compress"
+#define OPV_ACCOUNT_STREAMCOMPRESSLEVEL                 "accounts.account.stream-compress-level"
 // MessageArchiver
 #define OPV_ACCOUNT_HISTORYREPLICATE                    "accounts.account.history-replicate"
 #define OPV_ACCOUNT_HISTORYDUPLICATE                    "accounts.account.history-duplicate"
@@ -262,6 +263,9 @@
 #define OPV_XMPPSTREAMS_TIMEOUT_HANDSHAKE               "xmppstreams.timeout.handshake"
 #define OPV_XMPPSTREAMS_TIMEOUT_KEEPALIVE               "xmppstreams.timeout.keepalive"
 #define OPV_XMPPSTREAMS_TIMEOUT_DISCONNECT              "xmppstreams.timeout.disconnect"
+#define OPV_XMPPSTREAMS_BATCHING_ENABLED                "xmppstreams.batching.enabled"
+#define OPV_XMPPSTREAMS_BATCHING_MAXLATENCY             "xmppstreams.batching.max-latency"
+#define OPV_XMPPSTREAMS_BATCHING_MAXSIZE                "xmppstreams.batching.max-size"
 // RosterPlugin
 #define OPV_XMPPSTREAMS_TIMEOUT_ROSTERREQUEST           "xmppstreams.timeout.roster-request"
 
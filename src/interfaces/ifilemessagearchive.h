@@ -19,7 +19,7 @@ public:
 	virtual QString collectionDirPath(const Jid &AStreamJid, const Jid &AWith) const =0;
 	virtual QString collectionFilePath(const Jid &AStreamJid, const Jid &AWith, const QDateTime &AStart) const =0;
 	virtual IArchiveHeader loadFileHeader(const QString &AFilePath) const =0;
-	virtual IArchiveCollection loadFileCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader) const =0;
+	virtual IArchiveCollection loadFileCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader, int ALastMessages = -1) const =0;
 	virtual QList<IArchiveHeader> loadFileHeaders(const Jid &AStreamJid, const IArchiveRequest &ARequest) const =0;
 	virtual IArchiveHeader saveFileCollection(const Jid &AStreamJid, const IArchiveCollection &ACollection) =0;
 	virtual bool removeFileCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader) =0;
@@ -39,6 +39,6 @@ protected:
 	virtual void fileCollectionRemoved(const Jid &AStreamJid, const IArchiveHeader &AHeader) =0;
 };
 
-Q_DECLARE_INTERFACE(IFileMessageArchive,"Vacuum.Plugin.IFileMessageArchive/1.2")
+Q_DECLARE_INTERFACE(IFileMessageArchive,"Vacuum.Plugin.IFileMessageArchive/1.3")
 
 #endif // IFILEMESSAGEARCHIVE_H
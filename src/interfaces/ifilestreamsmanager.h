@@ -11,6 +11,24 @@
 
 #define FILESTREAMSMANAGER_UUID "{ea9ea27a-5ad7-40e3-82b3-db8ac3bdc288}"
 
+struct IPartialFileTransfer
+{
+	Jid contactJid;
+	QString fileName;
+	qint64 fileSize;
+	QString fileHash;
+	qint64 receivedSize;
+	QString receivedHash;
+
+	IPartialFileTransfer() {
+		fileSize = 0;
+		receivedSize = 0;
+	}
+	inline bool isNull() const {
+		return fileName.isEmpty();
+	}
+};
+
 class IFileStream
 {
 public:
@@ -91,15 +109,21 @@ public:
 	virtual QList<IFileStreamHandler *> streamHandlers() const =0;
 	virtual void insertStreamsHandler(int AOrder, IFileStreamHandler *AHandler) =0;
 	virtual void removeStreamsHandler(int AOrder, IFileStreamHandler *AHandler) =0;
+	// Partial Transfers
+	virtual QList<IPartialFileTransfer> partialTransfers() const =0;
+	virtual IPartialFileTransfer findPartialTransfer(const Jid &AContactJid, const QString &AFileName, qint64 AFileSize, const QString &AFileHash) const =0;
+	virtual void insertPartialTransfer(const IPartialFileTransfer &ATransfer) =0;
+	virtual void removePartialTransfer(const QString &AFileName) =0;
 protected:
 	virtual void streamCreated(IFileStream *AStream) =0;
 	virtual void streamDestroyed(IFileStream *AStream) =0;
 	virtual void streamHandlerInserted(int AOrder, IFileStreamHandler *AHandler) =0;
 	virtual void streamHandlerRemoved(int AOrder, IFileStreamHandler *AHandler) =0;
+	virtual void partialTransfersChanged() =0;
 };
 
 Q_DECLARE_INTERFACE(IFileStream,"Vacuum.Plugin.IFileStream/1.2")
 Q_DECLARE_INTERFACE(IFileStreamHandler,"Vacuum.Plugin.IFileStreamHandler/1.1")
-Q_DECLARE_INTERFACE(IFileStreamsManager,"Vacuum.Plugin.IFileStreamsManager/1.3")
+Q_DECLARE_INTERFACE(IFileStreamsManager,"Vacuum.Plugin.IFileStreamsManager/1.4")
 
 #endif // IFILESTREAMSMANAGER_H
@@ -156,6 +156,7 @@ struct IArchiveRequest
 	IArchiveRequest() {
 		openOnly = false;
 		exactmatch = false;
+		tailOnly = false;
 		maxItems = 0xFFFFFFFF;
 		threadId = QString::null;
 		order = Qt::AscendingOrder;
@@ -165,6 +166,7 @@ struct IArchiveRequest
 	QDateTime end;
 	bool openOnly;
 	bool exactmatch;
+	bool tailOnly;
 	QString text;
 	quint32 maxItems;
 	QString threadId;
@@ -205,7 +207,7 @@ public:
 	virtual QString saveCollection(const Jid &AStreamJid, const IArchiveCollection &ACollection) =0;
 	//Archive Management
 	virtual QString loadHeaders(const Jid &AStreamJid, const IArchiveRequest &ARequest) =0;
-	virtual QString loadCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader) =0;
+	virtual QString loadCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader, int ALastMessages = -1) =0;
 	virtual QString removeCollections(const Jid &AStreamJid, const IArchiveRequest &ARequest) =0;
 	//Archive Replication
 	virtual QString loadModifications(const Jid &AStreamJid, const QDateTime &AStart, int ACount, const QString &ANextRef) =0;
@@ -245,7 +247,7 @@ public:
 	//Archive Management
 	virtual QString loadMessages(const Jid &AStreamJid, const IArchiveRequest &ARequest) =0;
 	virtual QString loadHeaders(const Jid &AStreamJid, const IArchiveRequest &ARequest) =0;
-	virtual QString loadCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader) =0;
+	virtual QString loadCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader, int ALastMessages = -1) =0;
 	virtual QString removeCollections(const Jid &AStreamJid, const IArchiveRequest &ARequest) =0;
 	//Archive Utilities
 	virtual void elementToCollection(const Jid &AStreamJid, const QDomElement &AChatElem, IArchiveCollection &ACollection) const =0;
@@ -280,7 +282,7 @@ protected:
 };
 
 Q_DECLARE_INTERFACE(IArchiveHandler,"Vacuum.Plugin.IArchiveHandler/1.1")
-Q_DECLARE_INTERFACE(IArchiveEngine,"Vacuum.Plugin.IArchiveEngine/1.3")
-Q_DECLARE_INTERFACE(IMessageArchiver,"Vacuum.Plugin.IMessageArchiver/1.4")
+Q_DECLARE_INTERFACE(IArchiveEngine,"Vacuum.Plugin.IArchiveEngine/1.4")
+Q_DECLARE_INTERFACE(IMessageArchiver,"Vacuum.Plugin.IMessageArchiver/1.6")
 
 #endif // IMESSAGEARCHIVER_H
@@ -75,6 +75,10 @@ public:
 	virtual bool isKeepAliveTimerActive() const =0;
 	virtual void setKeepAliveTimerActive(bool AActive) =0;
 	virtual qint64 sendStanza(Stanza &AStanza) =0;
+	virtual bool isCorked() const =0;
+	virtual void cork() =0;
+	virtual void uncork() =0;
+	virtual void flush() =0;
 	virtual void insertXmppDataHandler(int AOrder, IXmppDataHandler *AHandler) =0;
 	virtual void removeXmppDataHandler(int AOrder, IXmppDataHandler *AHandler) =0;
 	virtual void insertXmppStanzaHandler(int AOrder, IXmppStanzaHadler *AHandler) =0;
@@ -133,7 +137,7 @@ Q_DECLARE_INTERFACE(IXmppDataHandler,"Vacuum.Plugin.IXmppDataHandler/1.0");
 Q_DECLARE_INTERFACE(IXmppStanzaHadler,"Vacuum.Plugin.IXmppStanzaHadler/1.0");
 Q_DECLARE_INTERFACE(IXmppFeature,"Vacuum.Plugin.IXmppFeature/1.1");
 Q_DECLARE_INTERFACE(IXmppFeatureFactory,"Vacuum.Plugin.IXmppFeatureFactory/1.1");
-Q_DECLARE_INTERFACE(IXmppStream, "Vacuum.Plugin.IXmppStream/1.4")
+Q_DECLARE_INTERFACE(IXmppStream, "Vacuum.Plugin.IXmppStream/1.5")
 Q_DECLARE_INTERFACE(IXmppStreamManager,"Vacuum.Plugin.IXmppStreamManager/1.4")
 
 #endif // IXMPPSTREAMMANAGER_H
@@ -3,8 +3,10 @@
 #include <QTimer>
 #include <QStack>
 #include <QThread>
+#include <QThreadPool>
 #include <QProcess>
 #include <QLibrary>
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include <QSettings>
 #include <QLibraryInfo>
@@ -23,6 +25,7 @@
 #include <utils/filestorage.h>
 #include <utils/shortcuts.h>
 #include <utils/action.h>
+#include <utils/jid.h>
 #include <utils/logger.h>
 
 #define START_SHUTDOWN_TIMEOUT      100
@@ -65,6 +68,22 @@
 #  define LIB_PREFIX_SIZE           3
 #endif
 
+LoadTranslatorTask::LoadTranslatorTask(QTranslator *ATranslator, const QString &AFileName, const QStringList &ADirs) : QRunnable()
+{
+	setAutoDelete(false);
+
+	FLoaded = false;
+	FDirs = ADirs;
+	FFileName = AFileName;
+	FTranslator = ATranslator;
+}
+
+void LoadTranslatorTask::run()
+{
+	for (int i=0; !FLoaded && i<FDirs.count(); i++)
+		FLoaded = FTranslator->load(FFileName,FDirs.at(i));
+}
+
 PluginManager::PluginManager(QApplication *AParent) : QObject(AParent)
 {
 	FQuitReady = false;
@@ -312,6 +331,12 @@ void PluginManager::loadSettings()
 		if (args.contains(CLO_LOG_TYPES))
 			logTypes = args.value(args.indexOf(CLO_LOG_TYPES)+1).toUInt();
 
+		if (args.contains(CLO_LOG_FLUSH_INTERVAL))
+			Logger::setFlushInterval(args.value(args.indexOf(CLO_LOG_FLUSH_INTERVAL)+1).toInt());
+
+		if (args.contains(CLO_LOG_MAX_FILE_SIZE))
+			Logger::setMaxFileSize(args.value(args.indexOf(CLO_LOG_MAX_FILE_SIZE)+1).toLongLong()*1024);
+
 		if (logTypes > 0)
 		{
 			Logger::setEnabledTypes(logTypes);
@@ -372,11 +397,18 @@ bool PluginManager::loadPlugins()
 		QString localeName = QLocale().name();
 		QDir tsDir(QApplication::applicationDirPath());
 		tsDir.cd(TRANSLATIONS_DIR);
-		loadCoreTranslations(tsDir,localeName);
 
 		QStringList files = pluginsDir.entryList(QDir::Files);
 		removePluginsInfo(files);
 
+		QStringList enabledFiles;
+		foreach (const QString &file, files)
+		{
+			if (QLibrary::isLibrary(file) && isPluginEnabled(file))
+				enabledFiles.append(file);
+		}
+		QHash<QString, QTranslator *> translators = loadTranslations(tsDir,localeName,enabledFiles);
+
 		foreach (const QString &file, files)
 		{
 			if (!QLibrary::isLibrary(file))
@@ -389,20 +421,14 @@ bool PluginManager::loadPlugins()
 			}
 			else
 			{
+				QElapsedTimer timer;
+				timer.start();
+
 				QPluginLoader *loader = new QPluginLoader(pluginsDir.absoluteFilePath(file),this);
 
-				QTranslator *translator = new QTranslator(loader);
-				QString tsFile = file.mid(LIB_PREFIX_SIZE,file.lastIndexOf('.')-LIB_PREFIX_SIZE);
-				if (translator->load(tsFile,tsDir.absoluteFilePath(localeName)) || translator->load(tsFile,tsDir.absoluteFilePath(localeName.left(2))))
-				{
-					qApp->installTranslator(translator);
-				}
-				else
-				{
-					delete translator;
-					translator = NULL;
-					LOG_DEBUG(QString("Failed to load translation for plugin %1").arg(file));
-				}
+				QTranslator *translator = translators.value(file);
+				if (translator != NULL)
+					translator->setParent(loader);
 
 				if (loader->load())
 				{
@@ -418,9 +444,12 @@ bool PluginManager::loadPlugins()
 							pluginItem.loader = loader;
 							pluginItem.info = new IPluginInfo;
 							pluginItem.translator =  translator;
+							for (int stage=0; stage<PSS_COUNT; stage++)
+								pluginItem.timing[stage] = 0;
 
 							plugin->pluginInfo(pluginItem.info);
 							savePluginInfo(file, pluginItem.info).setAttribute("uuid", uid.toString());
+							pluginItem.timing[PSS_LOAD] = timer.elapsed();
 
 							FPluginItems.insert(uid,pluginItem);
 							LOG_DEBUG(QString("Loaded plugin from file=%1, version=%2, uuid=%3").arg(file,pluginItem.info->version,uid.toString()));
@@ -489,8 +518,12 @@ bool PluginManager::initPlugins()
 	{
 		int initOrder = PIO_DEFAULT;
 		IPlugin *plugin = it.value().plugin;
+
+		QElapsedTimer timer;
+		timer.start();
 		if (plugin->initConnections(this,initOrder))
 		{
+			FPluginItems[it.key()].timing[PSS_INIT_CONNECTIONS] = timer.elapsed();
 			pluginOrder.insertMulti(initOrder,plugin);
 			++it;
 		}
@@ -505,11 +538,21 @@ bool PluginManager::initPlugins()
 
 	if (initOk)
 	{
+		QElapsedTimer timer;
+
 		foreach(IPlugin *plugin, pluginOrder)
+		{
+			timer.start();
 			plugin->initObjects();
+			FPluginItems[plugin->pluginUuid()].timing[PSS_INIT_OBJECTS] = timer.elapsed();
+		}
 
 		foreach(IPlugin *plugin, pluginOrder)
+		{
+			timer.start();
 			plugin->initSettings();
+			FPluginItems[plugin->pluginUuid()].timing[PSS_INIT_SETTINGS] = timer.elapsed();
+		}
 	}
 
 	return initOk;
@@ -520,9 +563,12 @@ bool PluginManager::startPlugins()
 	LOG_INFO("Starting plugins");
 
 	bool allStarted = true;
-	foreach(const PluginItem &pluginItem, FPluginItems)
+	QElapsedTimer timer;
+	for (QHash<QUuid, PluginItem>::iterator it=FPluginItems.begin(); it!=FPluginItems.end(); ++it)
 	{
-		bool started = pluginItem.plugin->startPlugin();
+		timer.start();
+		bool started = it->plugin->startPlugin();
+		it->timing[PSS_START] = timer.elapsed();
 		allStarted = allStarted && started;
 	}
 	return allStarted;
@@ -607,6 +653,7 @@ void PluginManager::finishQuit()
 				declareShortcuts();
 				startPlugins();
 				FBlockedPlugins.clear();
+				reportStartupTiming();
 				REPORT_TIMING(STMP_APPLICATION_START,Logger::finishTiming(STMP_APPLICATION_START));
 				LOG_INFO("Application started");
 			}
@@ -615,6 +662,7 @@ void PluginManager::finishQuit()
 		{
 			FQuitReady = true;
 			QTimer::singleShot(0,qApp,SLOT(quit()));
+			LOG_INFO(QString("Jid cache statistics: size=%1, hits=%2, misses=%3").arg(Jid::cacheSize()).arg(Jid::cacheHits()).arg(Jid::cacheMisses()));
 			REPORT_TIMING(STMP_APPLICATION_QUIT,Logger::finishTiming(STMP_APPLICATION_QUIT));
 		}
 	}
@@ -743,24 +791,55 @@ QList<QUuid> PluginManager::getConflicts(const QUuid &AUuid) const
 	return plugins.toList();
 }
 
-void PluginManager::loadCoreTranslations(const QDir &ADir, const QString &ALocaleName)
+QHash<QString, QTranslator *> PluginManager::loadTranslations(const QDir &ADir, const QString &ALocaleName, const QStringList &AFiles)
 {
-	if (FQtTranslator->load("qt_"+ALocaleName,ADir.absoluteFilePath(ALocaleName)) || FQtTranslator->load("qt_"+ALocaleName,ADir.absoluteFilePath(ALocaleName.left(2))))
-		qApp->installTranslator(FQtTranslator);
-	else if (FQtTranslator->load("qt_"+QLocale().name(), QLibraryInfo::location(QLibraryInfo::TranslationsPath)))
-		qApp->installTranslator(FQtTranslator);
-	else
-		LOG_DEBUG("Translation for 'Qt' not found");
+	QElapsedTimer timer;
+	timer.start();
 
-	if (FLoaderTranslator->load("vacuum",ADir.absoluteFilePath(ALocaleName)) || FLoaderTranslator->load("vacuum",ADir.absoluteFilePath(ALocaleName.left(2))))
-		qApp->installTranslator(FLoaderTranslator);
-	else
-		LOG_DEBUG("Translation for 'vacuum' not found");
+	QStringList dirs = QStringList() << ADir.absoluteFilePath(ALocaleName) << ADir.absoluteFilePath(ALocaleName.left(2));
 
-	if (FUtilsTranslator->load("vacuumutils",ADir.absoluteFilePath(ALocaleName)) || FUtilsTranslator->load("vacuumutils",ADir.absoluteFilePath(ALocaleName.left(2))))
-		qApp->installTranslator(FUtilsTranslator);
-	else
-		LOG_DEBUG("Translation for 'vacuumutils' not found");
+	QList<LoadTranslatorTask *> tasks;
+	tasks.append(new LoadTranslatorTask(FQtTranslator,"qt_"+ALocaleName,QStringList(dirs) << QLibraryInfo::location(QLibraryInfo::TranslationsPath)));
+	tasks.append(new LoadTranslatorTask(FLoaderTranslator,"vacuum",dirs));
+	tasks.append(new LoadTranslatorTask(FUtilsTranslator,"vacuumutils",dirs));
+
+	int coreCount = tasks.count();
+	foreach(const QString &file, AFiles)
+	{
+		QString tsFile = file.mid(LIB_PREFIX_SIZE,file.lastIndexOf('.')-LIB_PREFIX_SIZE);
+		tasks.append(new LoadTranslatorTask(new QTranslator(this),tsFile,dirs));
+	}
+
+	// Translators are only parsed in pool threads, installation is done here in original order
+	QThreadPool pool;
+	foreach(LoadTranslatorTask *task, tasks)
+		pool.start(task);
+	pool.waitForDone();
+
+	QHash<QString, QTranslator *> translators;
+	for (int i=0; i<tasks.count(); i++)
+	{
+		LoadTranslatorTask *task = tasks.at(i);
+		if (task->FLoaded)
+		{
+			qApp->installTranslator(task->FTranslator);
+			if (i >= coreCount)
+				translators.insert(AFiles.at(i-coreCount),task->FTranslator);
+		}
+		else if (i >= coreCount)
+		{
+			LOG_DEBUG(QString("Failed to load translation for plugin %1").arg(AFiles.at(i-coreCount)));
+			delete task->FTranslator;
+		}
+		else
+		{
+			LOG_DEBUG(QString("Translation for '%1' not found").arg(task->FFileName));
+		}
+	}
+	qDeleteAll(tasks);
+
+	LOG_DEBUG(QString("Translations loaded, count=%1, time=%2 ms").arg(translators.count()).arg(timer.elapsed()));
+	return translators;
 }
 
 bool PluginManager::isPluginEnabled(const QString &AFile) const
@@ -895,6 +974,37 @@ void PluginManager::declareShortcuts()
 	Shortcuts::declareGroup(SCTG_APPLICATION, tr("Application shortcuts"), SGO_APPLICATION);
 }
 
+void PluginManager::reportStartupTiming() const
+{
+	static const char *stageNames[PSS_COUNT] = { "load", "connections", "objects", "settings", "start" };
+
+	qint64 stageTotals[PSS_COUNT] = { 0, 0, 0, 0, 0 };
+	QMultiMap<qint64, QString> pluginReports;
+	for (QHash<QUuid, PluginItem>::const_iterator it=FPluginItems.constBegin(); it!=FPluginItems.constEnd(); ++it)
+	{
+		qint64 total = 0;
+		QStringList stages;
+		for (int stage=0; stage<PSS_COUNT; stage++)
+		{
+			total += it->timing[stage];
+			stageTotals[stage] += it->timing[stage];
+			stages.append(QString("%1=%2").arg(stageNames[stage]).arg(it->timing[stage]));
+		}
+		pluginReports.insertMulti(total,QString("Plugin startup timing, file=%1, total=%2 ms, %3").arg(QFileInfo(it->loader->fileName()).fileName()).arg(total).arg(stages.join(", ")));
+	}
+
+	QStringList totals;
+	for (int stage=0; stage<PSS_COUNT; stage++)
+		totals.append(QString("%1=%2").arg(stageNames[stage]).arg(stageTotals[stage]));
+	LOG_INFO(QString("Plugins startup timing, plugins=%1, %2 ms").arg(FPluginItems.count()).arg(totals.join(", ")));
+
+	// Slowest plugins first
+	QMapIterator<qint64, QString> reportIt(pluginReports);
+	reportIt.toBack();
+	while (reportIt.hasPrevious())
+		LOG_DEBUG(reportIt.previous().value());
+}
+
 void PluginManager::onApplicationAboutToQuit()
 {
 	LOG_INFO("Application about to quit");
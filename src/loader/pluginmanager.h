@@ -4,6 +4,7 @@
 #include <QDir>
 #include <QHash>
 #include <QPointer>
+#include <QRunnable>
 #include <QTranslator>
 #include <QDomDocument>
 #include <QApplication>
@@ -21,11 +22,34 @@ enum ShutdownKind {
 	SK_RESTART
 };
 
+enum PluginStartupStage {
+	PSS_LOAD,
+	PSS_INIT_CONNECTIONS,
+	PSS_INIT_OBJECTS,
+	PSS_INIT_SETTINGS,
+	PSS_START,
+	PSS_COUNT
+};
+
+class LoadTranslatorTask :
+	public QRunnable
+{
+public:
+	LoadTranslatorTask(QTranslator *ATranslator, const QString &AFileName, const QStringList &ADirs);
+	virtual void run();
+public:
+	bool FLoaded;
+	QStringList FDirs;
+	QString FFileName;
+	QTranslator *FTranslator;
+};
+
 struct PluginItem {
 	IPlugin *plugin;
 	IPluginInfo *info;
 	QPluginLoader *loader;
 	QTranslator *translator;
+	qint64 timing[PSS_COUNT];
 };
 
 class PluginManager :
@@ -78,7 +102,7 @@ protected:
 	bool checkDependences(const QUuid &AUuid) const;
 	bool checkConflicts(const QUuid &AUuid) const;
 	QList<QUuid> getConflicts(const QUuid &AUuid) const;
-	void loadCoreTranslations(const QDir &ADir, const QString &ALocaleName);
+	QHash<QString, QTranslator *> loadTranslations(const QDir &ADir, const QString &ALocaleName, const QStringList &AFiles);
 protected:
 	bool isPluginEnabled(const QString &AFile) const;
 	QDomElement savePluginInfo(const QString &AFile, const IPluginInfo *AInfo);
@@ -86,6 +110,7 @@ protected:
 	void removePluginsInfo(const QStringList &ACurFiles);
 	void createMenuActions();
 	void declareShortcuts();
+	void reportStartupTiming() const;
 protected slots:
 	void onApplicationAboutToQuit();
 	void onApplicationCommitDataRequested(QSessionManager &AManager);
@@ -17,6 +17,7 @@
 #include <QWebSettings>
 #include <QDomDocument>
 #include <QApplication>
+#include <QElapsedTimer>
 #include <QTextDocument>
 #include <QWebHitTestResult>
 #include <definitions/resources.h>
@@ -26,6 +27,8 @@
 
 #define SCROLL_TIMEOUT                      100
 #define CONTENT_TIMEOUT                     10
+#define CONTENT_BATCH_MAX_SIZE              256*1024
+#define CONTENT_BATCH_MAX_TIME              50
 
 #define CONSECUTIVE_TIMEOUT                 2*60
 
@@ -780,15 +783,43 @@ void AdiumMessageStyle::onScrollTimerTimeout()
 
 void AdiumMessageStyle::onContentTimerTimeout()
 {
+	QElapsedTimer budget;
+	budget.start();
+
+	bool hasPending = false;
 	for(QMap<QWidget *, WidgetStatus>::iterator it=FWidgetStatus.begin(); it!=FWidgetStatus.end(); ++it)
 	{
 		if (it->ready && !it->pending.isEmpty())
 		{
-			StyleViewer *view = qobject_cast<StyleViewer *>(it.key());
-			view->page()->mainFrame()->evaluateJavaScript(it->pending.takeFirst());
-			FContentTimer.start(CONTENT_TIMEOUT);
+			if (budget.elapsed() < CONTENT_BATCH_MAX_TIME)
+			{
+				// Evaluate pending scripts at once to avoid page layout for each appended message
+				int count = 0;
+				QString script;
+				while (!it->pending.isEmpty() && (script.isEmpty() || script.size()+it->pending.first().size()<=CONTENT_BATCH_MAX_SIZE))
+				{
+					script += it->pending.takeFirst();
+					count++;
+				}
+
+				QElapsedTimer timer;
+				timer.start();
+
+				StyleViewer *view = qobject_cast<StyleViewer *>(it.key());
+				view->page()->mainFrame()->evaluateJavaScript(script);
+
+				if (count > 1)
+				{
+					qint64 elapsed = qMax(timer.elapsed(),Q_INT64_C(1));
+					LOG_DEBUG(QString("Adium style content batch appended, messages=%1, size=%2, time=%3 ms, speed=%4 msg/sec").arg(count).arg(script.size()).arg(elapsed).arg(count*1000/elapsed));
+				}
+			}
+			hasPending = hasPending || !it->pending.isEmpty();
 		}
 	}
+
+	if (hasPending)
+		FContentTimer.start(CONTENT_TIMEOUT);
 }
 
 void AdiumMessageStyle::onLinkClicked(const QUrl &AUrl)
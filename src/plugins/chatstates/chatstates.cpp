@@ -486,7 +486,8 @@ bool ChatStates::isEnabled(const Jid &AContactJid, const Jid &AStreamJid) const
 	else if (status==IChatStates::StatusEnable)
 		return true;
 
-	return Options::node(OPV_MESSAGES_CHATSTATESENABLED).value().toBool();
+	static const OptionsValue chatStatesEnabled(OPV_MESSAGES_CHATSTATESENABLED);
+	return chatStatesEnabled.value().toBool();
 }
 
 bool ChatStates::isSupported(const Jid &AStreamJid, const Jid &AContactJid) const
@@ -7,12 +7,23 @@
 #include <utils/xmpperror.h>
 #include <utils/logger.h>
 
-#define CHUNK_SIZE   4096
+#define CHUNK_SIZE               4096
+#define MAX_KEEP_BUFFER_SIZE     262144
 
-CompressFeature::CompressFeature(IXmppStream *AXmppStream) : QObject(AXmppStream->instance())
+#define ADAPTIVE_START_LEVEL     6
+#define ADAPTIVE_MIN_LEVEL       1
+#define ADAPTIVE_MAX_LEVEL       9
+#define ADAPTIVE_SAMPLE_SIZE     65536
+#define ADAPTIVE_SLOW_SPEED      16     // MB/s
+#define ADAPTIVE_FAST_SPEED      64     // MB/s
+
+CompressFeature::CompressFeature(IXmppStream *AXmppStream, int ALevel) : QObject(AXmppStream->instance())
 {
 	FZlibInited = false;
 	FXmppStream = AXmppStream;
+
+	FAdaptive = ALevel<Z_NO_COMPRESSION || ALevel>Z_BEST_COMPRESSION;
+	FLevel = FAdaptive ? ADAPTIVE_START_LEVEL : ALevel;
 }
 
 CompressFeature::~CompressFeature()
@@ -119,7 +130,7 @@ bool CompressFeature::startZlib()
 		FDefStruc.zalloc = Z_NULL;
 		FDefStruc.zfree = Z_NULL;
 		FDefStruc.opaque = Z_NULL;
-		int retDef = deflateInit(&FDefStruc,Z_BEST_COMPRESSION);
+		int retDef = deflateInit(&FDefStruc,FLevel);
 
 		FInfStruc.zalloc = Z_NULL;
 		FInfStruc.zfree = Z_NULL;
@@ -131,7 +142,7 @@ bool CompressFeature::startZlib()
 		if (retInf == Z_OK && retDef == Z_OK)
 		{
 			FZlibInited = true;
-			FOutBuffer.reserve(CHUNK_SIZE);
+			FOutBuffer.resize(CHUNK_SIZE);
 		}
 		else
 		{
@@ -153,9 +164,10 @@ void CompressFeature::stopZlib()
 {
 	if (FZlibInited)
 	{
+		logStatistics();
 		deflateEnd(&FDefStruc);
 		inflateEnd(&FInfStruc);
-		FOutBuffer.squeeze();
+		FOutBuffer.clear();
 		FZlibInited = false;
 	}
 }
@@ -164,6 +176,8 @@ void CompressFeature::processData(QByteArray &AData, bool ADataOut)
 {
 	if (AData.size() > 0)
 	{
+		FTimer.start();
+
 		int ret;
 		int dataPosOut = 0;
 
@@ -171,9 +185,14 @@ void CompressFeature::processData(QByteArray &AData, bool ADataOut)
 		zstream->avail_in = AData.size();
 		zstream->next_in = (Bytef *)(AData.constData());
 
+		// Size output buffer to fit the whole result in most cases to avoid reallocations inside the loop
+		int estimatedSize = (ADataOut ? (int)deflateBound(zstream,AData.size()) : AData.size()*4) + CHUNK_SIZE;
+		if (FOutBuffer.size() < estimatedSize)
+			FOutBuffer.resize(estimatedSize);
+
 		do
 		{
-			zstream->avail_out = FOutBuffer.capacity() - dataPosOut;
+			zstream->avail_out = FOutBuffer.size() - dataPosOut;
 			zstream->next_out = (Bytef *)(FOutBuffer.data() + dataPosOut);
 			ret = ADataOut ? deflate(zstream,Z_SYNC_FLUSH) : inflate(zstream,Z_SYNC_FLUSH);
 
@@ -183,9 +202,9 @@ void CompressFeature::processData(QByteArray &AData, bool ADataOut)
 			switch (ret)
 			{
 			case Z_OK:
-				dataPosOut = FOutBuffer.capacity() - zstream->avail_out;
+				dataPosOut = FOutBuffer.size() - zstream->avail_out;
 				if (zstream->avail_out == 0)
-					FOutBuffer.reserve(FOutBuffer.capacity() + CHUNK_SIZE);
+					FOutBuffer.resize(FOutBuffer.size()*2);
 				break;
 			case Z_STREAM_ERROR:
 				emit error(XmppError(IERR_COMPRESS_INVALID_COMPRESSION_LEVEL));
@@ -203,8 +222,76 @@ void CompressFeature::processData(QByteArray &AData, bool ADataOut)
 				emit error(XmppError(IERR_COMPRESS_UNKNOWN_ERROR,tr("Error code: %1").arg(ret)));
 			}
 		} while (ret == Z_OK && zstream->avail_out == 0);
-		
+
+		qint64 bytesIn = AData.size();
 		AData.resize(dataPosOut);
 		memcpy(AData.data(),FOutBuffer.constData(),dataPosOut);
+
+		if (FOutBuffer.size() > MAX_KEEP_BUFFER_SIZE)
+		{
+			FOutBuffer.resize(CHUNK_SIZE);
+			FOutBuffer.squeeze();
+		}
+
+		qint64 nsecs = FTimer.nsecsElapsed();
+		if (ADataOut)
+		{
+			updateStatistics(FDeflateStats,bytesIn,dataPosOut,nsecs);
+			if (FAdaptive)
+			{
+				updateStatistics(FSample,bytesIn,dataPosOut,nsecs);
+				if (FSample.bytesIn >= ADAPTIVE_SAMPLE_SIZE)
+					adaptCompressionLevel();
+			}
+		}
+		else
+		{
+			updateStatistics(FInflateStats,bytesIn,dataPosOut,nsecs);
+		}
 	}
 }
+
+void CompressFeature::updateStatistics(CompressStatistics &AStats, qint64 ABytesIn, qint64 ABytesOut, qint64 ANSecs)
+{
+	AStats.bytesIn += ABytesIn;
+	AStats.bytesOut += ABytesOut;
+	AStats.nsecs += ANSecs;
+}
+
+void CompressFeature::adaptCompressionLevel()
+{
+	// Speed in MB/s: bytes per nanosecond multiplied by 1000
+	qint64 speed = FSample.nsecs>0 ? FSample.bytesIn*1000/FSample.nsecs : ADAPTIVE_FAST_SPEED;
+
+	int level = FLevel;
+	if (speed<ADAPTIVE_SLOW_SPEED && level>ADAPTIVE_MIN_LEVEL)
+		level--;
+	else if (speed>ADAPTIVE_FAST_SPEED && level<ADAPTIVE_MAX_LEVEL)
+		level++;
+
+	if (level != FLevel)
+	{
+		int ret = deflateParams(&FDefStruc,level,Z_DEFAULT_STRATEGY);
+		if (ret == Z_OK)
+		{
+			LOG_STRM_DEBUG(FXmppStream->streamJid(),QString("Stream compression level changed from=%1 to=%2, speed=%3 MB/s, ratio=%4").arg(FLevel).arg(level).arg(speed).arg((double)FSample.bytesOut/FSample.bytesIn,0,'f',3));
+			FLevel = level;
+		}
+		else
+		{
+			LOG_STRM_WARNING(FXmppStream->streamJid(),QString("Failed to change stream compression level to=%1: %2").arg(level).arg(ret));
+		}
+	}
+
+	FSample = CompressStatistics();
+}
+
+void CompressFeature::logStatistics() const
+{
+	double deflateRatio = FDeflateStats.bytesIn>0 ? (double)FDeflateStats.bytesOut/FDeflateStats.bytesIn : 1.0;
+	double inflateRatio = FInflateStats.bytesOut>0 ? (double)FInflateStats.bytesIn/FInflateStats.bytesOut : 1.0;
+	LOG_STRM_INFO(FXmppStream->streamJid(),QString("Stream compression statistics: level=%1, sent=%2/%3 bytes, ratio=%4, time=%5 ms; received=%6/%7 bytes, ratio=%8, time=%9 ms")
+		.arg(FAdaptive ? QString("adaptive(%1)").arg(FLevel) : QString::number(FLevel))
+		.arg(FDeflateStats.bytesIn).arg(FDeflateStats.bytesOut).arg(deflateRatio,0,'f',3).arg(FDeflateStats.nsecs/1000000)
+		.arg(FInflateStats.bytesOut).arg(FInflateStats.bytesIn).arg(inflateRatio,0,'f',3).arg(FInflateStats.nsecs/1000000));
+}
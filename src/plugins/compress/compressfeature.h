@@ -1,6 +1,7 @@
 #ifndef COMPRESSFEATURE_H
 #define COMPRESSFEATURE_H
 
+#include <QElapsedTimer>
 #include <interfaces/ixmppstreammanager.h>
 
 #ifdef USE_SYSTEM_ZLIB
@@ -9,6 +10,19 @@
 #	include <thirdparty/zlib/zlib.h>
 #endif
 
+#define COMPRESS_LEVEL_ADAPTIVE   -1
+
+struct CompressStatistics {
+	CompressStatistics() {
+		bytesIn = 0;
+		bytesOut = 0;
+		nsecs = 0;
+	}
+	qint64 bytesIn;
+	qint64 bytesOut;
+	qint64 nsecs;
+};
+
 class CompressFeature :
 	public QObject,
 	public IXmppFeature,
@@ -18,7 +32,7 @@ class CompressFeature :
 	Q_OBJECT;
 	Q_INTERFACES(IXmppFeature IXmppDataHandler IXmppStanzaHadler);
 public:
-	CompressFeature(IXmppStream *AXmppStream);
+	CompressFeature(IXmppStream *AXmppStream, int ALevel = COMPRESS_LEVEL_ADAPTIVE);
 	~CompressFeature();
 	//IXmppDataHandler
 	virtual bool xmppDataIn(IXmppStream *AXmppStream, QByteArray &AData, int AOrder);
@@ -39,13 +53,23 @@ protected:
 	bool startZlib();
 	void stopZlib();
 	void processData(QByteArray &AData, bool ADataOut);
+	void updateStatistics(CompressStatistics &AStats, qint64 ABytesIn, qint64 ABytesOut, qint64 ANSecs);
+	void adaptCompressionLevel();
+	void logStatistics() const;
 private:
 	IXmppStream *FXmppStream;
 private:
 	bool FZlibInited;
+	bool FAdaptive;
+	int FLevel;
 	z_stream FDefStruc;
 	z_stream FInfStruc;
 	QByteArray FOutBuffer;
+	QElapsedTimer FTimer;
+private:
+	CompressStatistics FSample;
+	CompressStatistics FDeflateStats;
+	CompressStatistics FInflateStats;
 };
 
 #endif // COMPRESSFEATURE_H
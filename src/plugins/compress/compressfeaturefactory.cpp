@@ -85,6 +85,7 @@ bool CompressFeatureFactory::initObjects()
 bool CompressFeatureFactory::initSettings()
 {
 	Options::setDefaultValue(OPV_ACCOUNT_STREAMCOMPRESS,false);
+	Options::setDefaultValue(OPV_ACCOUNT_STREAMCOMPRESSLEVEL,COMPRESS_LEVEL_ADAPTIVE);
 	return true;
 }
 
@@ -115,8 +116,9 @@ IXmppFeature *CompressFeatureFactory::newXmppFeature(const QString &AFeatureNS,
 		IAccount *account = FAccountManager!=NULL ? FAccountManager->findAccountByStream(AXmppStream->streamJid()) : NULL;
 		if (account==NULL || account->optionsNode().value("stream-compress").toBool())
 		{
-			LOG_STRM_INFO(AXmppStream->streamJid(),"Compression XMPP stream feature created");
-			IXmppFeature *feature = new CompressFeature(AXmppStream);
+			int level = account!=NULL ? account->optionsNode().value("stream-compress-level").toInt() : COMPRESS_LEVEL_ADAPTIVE;
+			LOG_STRM_INFO(AXmppStream->streamJid(),QString("Compression XMPP stream feature created, level=%1").arg(level));
+			IXmppFeature *feature = new CompressFeature(AXmppStream,level);
 			connect(feature->instance(),SIGNAL(featureDestroyed()),SLOT(onFeatureDestroyed()));
 			emit featureCreated(feature);
 			return feature;
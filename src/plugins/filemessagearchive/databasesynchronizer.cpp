@@ -3,11 +3,17 @@
 #include <QMutexLocker>
 #include <QDirIterator>
 #include <definitions/statisticsparams.h>
+#include <definitions/filearchivedatabaseproperties.h>
 #include <utils/logger.h>
 
+#define SYNC_BATCH_HEADERS      1000
+#define SYNC_BATCH_TEXTS        20000
+
 DatabaseSynchronizer::DatabaseSynchronizer(IFileMessageArchive *AFileArchive, DatabaseWorker *ADatabaseWorker, QObject *AParent) : QThread(AParent)
 {
 	FQuit = false;
+	FBatchTexts = 0;
+	FRowsWritten = 0;
 	FFileArchive = AFileArchive;
 	FDatabaseWorker = ADatabaseWorker;
 }
@@ -53,9 +59,15 @@ void DatabaseSynchronizer::run()
 		bool syncFailed = false;
 		QDateTime syncTime = QDateTime::currentDateTime();
 
+		clearBatch();
+		FRowsWritten = 0;
+
 		QString archivePath = FFileArchive->fileArchivePath(streamJid);
 		if (!archivePath.isEmpty())
 		{
+			// Full-text index should be built for all collections, not only for changed ones
+			bool indexAllTexts = FFileArchive->databaseProperty(streamJid,FADP_TEXT_INDEX_READY)!="true";
+
 			IArchiveRequest loadRequest;
 			QHash<Jid, QList<QString> > databaseHeadersMap;
 			QHash<QString, DatabaseArchiveHeader> databaseFileHeaders;
@@ -96,11 +108,11 @@ void DatabaseSynchronizer::run()
 				{
 					filesIt.next();
 					QDateTime fileLastModified = filesIt.fileInfo().lastModified();
-					if (fileLastModified < syncTime)
+					if (fileLastModified<syncTime && !filesIt.fileName().endsWith(COLLECTION_INDEX_EXT))
 					{
 						QString fileName = filesIt.filePath().mid(pathLength).toLower();
 						QHash<QString, DatabaseArchiveHeader>::iterator dbHeaderIt = databaseFileHeaders.find(fileName);
-						if (dbHeaderIt==databaseFileHeaders.end() || dbHeaderIt->timestamp<fileLastModified)
+						if (indexAllTexts || dbHeaderIt==databaseFileHeaders.end() || dbHeaderIt->timestamp<fileLastModified)
 						{
 							IArchiveHeader header = FFileArchive->loadFileHeader(filesIt.filePath());
 							if (header.with.isValid() && header.start.isValid() && !fileHeadersMap.value(header.with).contains(header))
@@ -127,6 +139,7 @@ void DatabaseSynchronizer::run()
 				QList<IArchiveHeader> newHeaders;
 				QList<IArchiveHeader> difHeaders;
 				QList<IArchiveHeader> oldHeaders;
+				QList<IArchiveHeader> textHeaders;
 
 				QList<IArchiveHeader> &fileHeaders = it.value();
 				qSort(fileHeaders.begin(),fileHeaders.end());
@@ -173,58 +186,29 @@ void DatabaseSynchronizer::run()
 					}
 					else
 					{
+						if (indexAllTexts)
+							textHeaders += fileHeaders.first();
 						fileHeaders.removeFirst();
 						databaseHeaders.removeFirst();
 					}
 				}
 
-				if (!syncFailed && !newHeaders.isEmpty())
-				{
-					QString gateType = with.hasNode() ? FFileArchive->contactGateType(with) : QString::null;
-					DatabaseTaskInsertHeaders *insertTask = new DatabaseTaskInsertHeaders(streamJid,newHeaders,gateType);
-					if (!FDatabaseWorker->execTask(insertTask))
-					{
-						syncFailed = true;
-						REPORT_ERROR("Failed to synchronize file archive database: Insert new headers task not executed");
-					}
-					else if(insertTask->isFailed())
-					{
-						syncFailed = true;
-						REPORT_ERROR("Failed to synchronize file archive database: Insert new headers task failed");
-					}
-					delete insertTask;
-				}
+				textHeaders += newHeaders;
+				textHeaders += difHeaders;
 
-				if (!syncFailed && !difHeaders.isEmpty())
-				{
-					DatabaseTaskUpdateHeaders *updateTask = new DatabaseTaskUpdateHeaders(streamJid,difHeaders);
-					if (!FDatabaseWorker->execTask(updateTask))
-					{
-						syncFailed = true;
-						REPORT_ERROR("Failed to synchronize file archive database: Update changed headers task not executed");
-					}
-					else if (updateTask->isFailed())
-					{
-						syncFailed = true;
-						REPORT_ERROR("Failed to synchronize file archive database: Update changed headers task failed");
-					}
-					delete updateTask;
-				}
+				if (!newHeaders.isEmpty())
+					FNewHeaders[with.hasNode() ? FFileArchive->contactGateType(with) : QString::null] += newHeaders;
+				FDifHeaders += difHeaders;
+				FOldHeaders += oldHeaders;
+				syncFailed = !writeBatch(streamJid,false);
 
-				if (!syncFailed && !oldHeaders.isEmpty())
+				for (int i=0; !FQuit && !syncFailed && i<textHeaders.count(); i++)
 				{
-					DatabaseTaskRemoveHeaders *removeTask = new DatabaseTaskRemoveHeaders(streamJid,oldHeaders);
-					if (!FDatabaseWorker->execTask(removeTask))
-					{
-						syncFailed = true;
-						REPORT_ERROR("Failed to synchronize file archive database: Remove old headers task not executed");
-					}
-					else if (removeTask->isFailed())
-					{
-						syncFailed = true;
-						REPORT_ERROR("Failed to synchronize file archive database: Remove old headers task failed");
-					}
-					delete removeTask;
+					IArchiveCollection collection = FFileArchive->loadFileCollection(streamJid,textHeaders.at(i));
+					FTextHeaders.append(textHeaders.at(i));
+					FTexts.append(DatabaseTaskUpdateTexts::collectionTexts(collection));
+					FBatchTexts += FTexts.last().count();
+					syncFailed = !writeBatch(streamJid,false);
 				}
 			}
 
@@ -239,22 +223,13 @@ void DatabaseSynchronizer::run()
 						oldHeaders.append(dbHeaderIt.value());
 				}
 
-				if (!oldHeaders.isEmpty())
-				{
-					DatabaseTaskRemoveHeaders *removeTask = new DatabaseTaskRemoveHeaders(streamJid,oldHeaders);
-					if (!FDatabaseWorker->execTask(removeTask))
-					{
-						syncFailed = true;
-						REPORT_ERROR("Failed to synchronize file archive database: Remove old headers task not executed");
-					}
-					else if (removeTask->isFailed())
-					{
-						syncFailed = true;
-						REPORT_ERROR("Failed to synchronize file archive database: Remove old headers task failed");
-					}
-					delete removeTask;
-				}
+				FOldHeaders += oldHeaders;
+				syncFailed = !writeBatch(streamJid,false);
 			}
+
+			if (!FQuit && !syncFailed)
+				syncFailed = !writeBatch(streamJid,true);
+			clearBatch();
 		}
 		else
 		{
@@ -266,8 +241,65 @@ void DatabaseSynchronizer::run()
 			QMetaObject::invokeMethod(this,"syncFinished",Qt::QueuedConnection,Q_ARG(const Jid &,streamJid),Q_ARG(bool,syncFailed));
 
 		if (!syncFailed)
+		{
+			qint64 syncMsecs = Logger::checkTiming(STMP_HISTORY_FILE_DATABASE_SYNC);
+			LOG_STRM_INFO(streamJid,QString("Database synchronization written rows=%1, time=%2 ms, speed=%3 rows/s").arg(FRowsWritten).arg(syncMsecs).arg(syncMsecs>0 ? FRowsWritten*1000/syncMsecs : FRowsWritten));
 			REPORT_TIMING(STMP_HISTORY_FILE_DATABASE_SYNC,Logger::finishTiming(STMP_HISTORY_FILE_DATABASE_SYNC));
+		}
 
 		locker.relock();
 	}
 }
+
+void DatabaseSynchronizer::clearBatch()
+{
+	FBatchTexts = 0;
+	FTexts.clear();
+	FTextHeaders.clear();
+	FDifHeaders.clear();
+	FOldHeaders.clear();
+	FNewHeaders.clear();
+}
+
+bool DatabaseSynchronizer::writeBatch(const Jid &AStreamJid, bool AForce)
+{
+	int batchHeaders = FDifHeaders.count() + FOldHeaders.count();
+	for (QMap<QString, QList<IArchiveHeader> >::const_iterator it=FNewHeaders.constBegin(); it!=FNewHeaders.constEnd(); ++it)
+		batchHeaders += it->count();
+
+	if (AForce || batchHeaders>=SYNC_BATCH_HEADERS || FBatchTexts>=SYNC_BATCH_TEXTS)
+	{
+		bool written = true;
+		for (QMap<QString, QList<IArchiveHeader> >::const_iterator it=FNewHeaders.constBegin(); written && it!=FNewHeaders.constEnd(); ++it)
+			written = execSyncTask(new DatabaseTaskInsertHeaders(AStreamJid,it.value(),it.key()),"Insert new headers");
+
+		if (written && !FDifHeaders.isEmpty())
+			written = execSyncTask(new DatabaseTaskUpdateHeaders(AStreamJid,FDifHeaders),"Update changed headers");
+
+		if (written && !FOldHeaders.isEmpty())
+			written = execSyncTask(new DatabaseTaskRemoveHeaders(AStreamJid,FOldHeaders),"Remove old headers");
+
+		if (written && !FTextHeaders.isEmpty())
+			written = execSyncTask(new DatabaseTaskUpdateTexts(AStreamJid,FTextHeaders,FTexts,true),"Update collection texts");
+
+		if (written)
+			FRowsWritten += batchHeaders + FBatchTexts;
+
+		clearBatch();
+		return written;
+	}
+	return true;
+}
+
+bool DatabaseSynchronizer::execSyncTask(DatabaseTask *ATask, const QString &AAction)
+{
+	bool executed = FDatabaseWorker->execTask(ATask);
+	if (!executed)
+		REPORT_ERROR(QString("Failed to synchronize file archive database: %1 task not executed").arg(AAction));
+	else if (ATask->isFailed())
+		REPORT_ERROR(QString("Failed to synchronize file archive database: %1 task failed").arg(AAction));
+
+	bool succeeded = executed && !ATask->isFailed();
+	delete ATask;
+	return succeeded;
+}
@@ -6,6 +6,7 @@
 #include <QThread>
 #include <interfaces/ifilemessagearchive.h>
 #include "databaseworker.h"
+#include "filewriter.h"
 
 class DatabaseSynchronizer :
 	public QThread
@@ -22,12 +23,23 @@ signals:
 	void syncFinished(const Jid &AStreamJid, bool AFailed);
 protected:
 	void run();
+	void clearBatch();
+	bool writeBatch(const Jid &AStreamJid, bool AForce);
+	bool execSyncTask(DatabaseTask *ATask, const QString &AAction);
 private:
 	bool FQuit;
 	QMutex FMutex;
 	QQueue<Jid> FStreams;
 	DatabaseWorker *FDatabaseWorker;
 	IFileMessageArchive *FFileArchive;
+private:
+	int FBatchTexts;
+	qint64 FRowsWritten;
+	QList<QStringList> FTexts;
+	QList<IArchiveHeader> FTextHeaders;
+	QList<IArchiveHeader> FDifHeaders;
+	QList<IArchiveHeader> FOldHeaders;
+	QMap<QString, QList<IArchiveHeader> > FNewHeaders;
 };
 
 #endif // DATABASESYNCHRONIZER_H
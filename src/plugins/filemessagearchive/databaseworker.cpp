@@ -1,5 +1,6 @@
 #include "databaseworker.h"
 
+#include <QRegExp>
 #include <QSqlQuery>
 #include <QMetaObject>
 #include <QMutexLocker>
@@ -9,9 +10,37 @@
 #include <utils/datetime.h>
 #include <utils/logger.h>
 
-#define DATABASE_STRUCTURE_VERSION     1
+#define DATABASE_STRUCTURE_VERSION     3
 #define DATABASE_COMPATIBLE_VERSION    1
 
+// Converts user search text to FTS phrase query with prefix matching of the last word,
+// like the substring search used when full-text index is not ready
+static QString textMatchQuery(const QString &AText)
+{
+	QStringList words;
+	foreach(QString word, AText.toLower().split(QRegExp("\\s+"),QString::SkipEmptyParts))
+	{
+		word.remove('"').remove('*');
+		if (!word.isEmpty())
+			words.append(word);
+	}
+	return !words.isEmpty() ? QString("\"%1*\"").arg(words.join(" ")) : QString::null;
+}
+
+// Modifications are not rebuilt from collection files, so transactions writing them are fully synced
+class FullSyncLocker
+{
+public:
+	FullSyncLocker(const QSqlDatabase &ADatabase) : FDatabase(ADatabase) {
+		QSqlQuery(FDatabase).exec("PRAGMA synchronous = FULL");
+	}
+	~FullSyncLocker() {
+		QSqlQuery(FDatabase).exec("PRAGMA synchronous = NORMAL");
+	}
+private:
+	QSqlDatabase FDatabase;
+};
+
 // DatabaseTask
 quint32 DatabaseTask::FTaskCount = 0;
 DatabaseTask::DatabaseTask(const Jid &AStreamJid, Type AType)	
@@ -139,6 +168,21 @@ bool DatabaseTaskOpenDatabase::initializeDatabase(QSqlDatabase &ADatabase)
 {
 	QSqlQuery query(ADatabase);
 
+	// Headers and texts are rebuilt from collection files, so durability is traded for write speed.
+	// Modifications can not be rebuilt, their transactions are synced with FullSyncLocker.
+	static const char *pragmas[] = {
+		"PRAGMA journal_mode = WAL",
+		"PRAGMA synchronous = NORMAL",
+		"PRAGMA cache_size = 4096",
+		"PRAGMA temp_store = MEMORY",
+		NULL
+	};
+	for (int i=0; pragmas[i]!=NULL; i++)
+	{
+		if (!query.exec(pragmas[i]))
+			Logger::writeLog(Logger::Warning,"DatabaseTaskOpenDatabase",QString("Failed to set file archive database pragma '%1': %2").arg(pragmas[i],query.lastError().databaseText()));
+	}
+
 	if (ADatabase.tables().contains("properties"))
 	{
 		if (query.exec("SELECT property, value FROM properties"))
@@ -213,7 +257,43 @@ bool DatabaseTaskOpenDatabase::initializeDatabase(QSqlDatabase &ADatabase)
 				"INSERT INTO properties(property,value) VALUES('StructureVersion','1');"
 				"INSERT INTO properties(property,value) VALUES('CompatibleVersion','1');"
 				, 1
-			} 
+			},
+			{
+				"CREATE INDEX headers_gateway_start ON headers ("
+				"  gateway          ASC,"
+				"  start            DESC"
+				");"
+
+				"CREATE INDEX headers_thread ON headers ("
+				"  thread           ASC"
+				");"
+
+				"UPDATE properties SET value='2' WHERE property='StructureVersion';"
+				, 1
+			},
+			{
+				"CREATE TABLE texts ("
+				"  id               INTEGER PRIMARY KEY,"
+				"  with_node        TEXT,"
+				"  with_domain      TEXT NOT NULL,"
+				"  with_resource    TEXT,"
+				"  start            DATETIME NOT NULL"
+				");"
+
+				"CREATE INDEX texts_with_start ON texts ("
+				"  with_node        ASC,"
+				"  with_domain      ASC,"
+				"  with_resource    ASC,"
+				"  start            DESC"
+				");"
+
+				"CREATE VIRTUAL TABLE texts_fts USING fts3("
+				"  body"
+				");"
+
+				"UPDATE properties SET value='3' WHERE property='StructureVersion';"
+				, 1
+			}
 		};
 
 		ADatabase.transaction();
@@ -319,8 +399,9 @@ void DatabaseTaskSetProperty::run()
 }
 
 // DatabaseTaskLoadHeaders
-DatabaseTaskLoadHeaders::DatabaseTaskLoadHeaders(const Jid &AStreamJid, const IArchiveRequest &ARequest, const QString &AGateType) : DatabaseTask(AStreamJid,LoadHeaders)
+DatabaseTaskLoadHeaders::DatabaseTaskLoadHeaders(const Jid &AStreamJid, const IArchiveRequest &ARequest, const QString &AGateType, quint32 AOffset) : DatabaseTask(AStreamJid,LoadHeaders)
 {
+	FOffset = AOffset;
 	FRequest = ARequest;
 	FGateType = AGateType;
 }
@@ -347,6 +428,17 @@ void DatabaseTaskLoadHeaders::run()
 			QStringList conditions;
 			QVariantList bindValues;
 
+			QString textQuery = !FRequest.text.isEmpty() ? textMatchQuery(FRequest.text) : QString::null;
+			if (!textQuery.isEmpty())
+			{
+				command += 
+					" JOIN (SELECT texts.with_node AS text_node, texts.with_domain AS text_domain, texts.with_resource AS text_resource, texts.start AS text_start, COUNT(*) AS rank"
+					" FROM texts_fts JOIN texts ON texts.id = texts_fts.docid WHERE texts_fts MATCH ?"
+					" GROUP BY texts.with_node, texts.with_domain, texts.with_resource, texts.start)"
+					" ON with_node = text_node AND with_domain = text_domain AND with_resource = text_resource AND start = text_start";
+				bindValues.append(textQuery);
+			}
+
 			if (FRequest.with.hasNode())
 			{
 				conditions.append("(with_node = ?)");
@@ -402,10 +494,16 @@ void DatabaseTaskLoadHeaders::run()
 				command += QString (" WHERE %1").arg(conditions.join(" AND "));
 			}
 
-			command += QString(" ORDER BY start %1").arg(FRequest.order==Qt::AscendingOrder ? "ASC" : "DESC");
+			if (!textQuery.isEmpty())
+				command += QString(" ORDER BY rank DESC, start %1").arg(FRequest.order==Qt::AscendingOrder ? "ASC" : "DESC");
+			else
+				command += QString(" ORDER BY start %1").arg(FRequest.order==Qt::AscendingOrder ? "ASC" : "DESC");
 
 			command += QString(" LIMIT %1").arg(FRequest.maxItems);
 
+			if (FOffset > 0)
+				command += QString(" OFFSET %1").arg(FOffset);
+
 			QSqlQuery selectQuery(db);
 			if (!selectQuery.prepare(command))
 			{
@@ -475,6 +573,7 @@ void DatabaseTaskInsertHeaders::run()
 		}
 		else if (!FHeaders.isEmpty())
 		{
+			FullSyncLocker fullSync(db);
 			db.transaction();
 			foreach(const IArchiveHeader &header, FHeaders)
 			{
@@ -559,6 +658,7 @@ void DatabaseTaskUpdateHeaders::run()
 		}
 		else if (!FHeaders.isEmpty())
 		{
+			FullSyncLocker fullSync(db);
 			db.transaction();
 			foreach(const IArchiveHeader &header, FHeaders)
 			{
@@ -653,11 +753,24 @@ void DatabaseTaskRemoveHeaders::run()
 	{
 		QSqlQuery removeQuery(db);
 		QSqlQuery modifyQuery(db);
+		QSqlQuery removeTextsQuery(db);
+		QSqlQuery removeTextIndexQuery(db);
 		if (!removeQuery.prepare(
 			"DELETE FROM headers WHERE with_node=:with_n AND with_domain=:with_d AND with_resource=:with_r AND start=:start"))
 		{
 			setSQLError(removeQuery.lastError());
 		}
+		else if (!removeTextIndexQuery.prepare(
+			"DELETE FROM texts_fts WHERE docid IN "
+			"(SELECT id FROM texts WHERE with_node=:with_n AND with_domain=:with_d AND with_resource=:with_r AND start=:start)"))
+		{
+			setSQLError(removeTextIndexQuery.lastError());
+		}
+		else if (!removeTextsQuery.prepare(
+			"DELETE FROM texts WHERE with_node=:with_n AND with_domain=:with_d AND with_resource=:with_r AND start=:start"))
+		{
+			setSQLError(removeTextsQuery.lastError());
+		}
 		else if (!modifyQuery.prepare(
 			"INSERT OR REPLACE INTO modifications (timestamp, action, with, start, version) "
 			"VALUES (:timestamp, :action, :with, :start, :version)"))
@@ -666,6 +779,7 @@ void DatabaseTaskRemoveHeaders::run()
 		}
 		else if (!FHeaders.isEmpty())
 		{
+			FullSyncLocker fullSync(db);
 			db.transaction();
 			foreach(const IArchiveHeader &header, FHeaders)
 			{
@@ -674,6 +788,16 @@ void DatabaseTaskRemoveHeaders::run()
 				bindQueryValue(removeQuery,":with_r",header.with.pResource());
 				bindQueryValue(removeQuery,":start",DateTime(header.start).toX85UTC());
 
+				bindQueryValue(removeTextIndexQuery,":with_n",header.with.pNode());
+				bindQueryValue(removeTextIndexQuery,":with_d",header.with.pDomain());
+				bindQueryValue(removeTextIndexQuery,":with_r",header.with.pResource());
+				bindQueryValue(removeTextIndexQuery,":start",DateTime(header.start).toX85UTC());
+
+				bindQueryValue(removeTextsQuery,":with_n",header.with.pNode());
+				bindQueryValue(removeTextsQuery,":with_d",header.with.pDomain());
+				bindQueryValue(removeTextsQuery,":with_r",header.with.pResource());
+				bindQueryValue(removeTextsQuery,":start",DateTime(header.start).toX85UTC());
+
 				bindQueryValue(modifyQuery,":timestamp",DateTime(QDateTime::currentDateTime()).toX85UTC());
 				bindQueryValue(modifyQuery,":action",IArchiveModification::Removed);
 				bindQueryValue(modifyQuery,":with",header.with.pFull());
@@ -692,6 +816,145 @@ void DatabaseTaskRemoveHeaders::run()
 					db.rollback();
 					return;
 				}
+				else if (!removeTextIndexQuery.exec())
+				{
+					setSQLError(removeTextIndexQuery.lastError());
+					db.rollback();
+					return;
+				}
+				else if (!removeTextsQuery.exec())
+				{
+					setSQLError(removeTextsQuery.lastError());
+					db.rollback();
+					return;
+				}
+			}
+			db.commit();
+		}
+	}
+	else
+	{
+		FError = XmppError(IERR_FILEARCHIVE_DATABASE_NOT_OPENED);
+	}
+}
+
+// DatabaseTaskUpdateTexts
+DatabaseTaskUpdateTexts::DatabaseTaskUpdateTexts(const Jid &AStreamJid, const QList<IArchiveHeader> &AHeaders, const QList<QStringList> &ATexts, bool AReplace) : DatabaseTask(AStreamJid,UpdateTexts)
+{
+	FTexts = ATexts;
+	FHeaders = AHeaders;
+	FReplace = AReplace;
+}
+
+QList<IArchiveHeader> DatabaseTaskUpdateTexts::headers() const
+{
+	return FHeaders;
+}
+
+QStringList DatabaseTaskUpdateTexts::collectionTexts(const IArchiveCollection &ACollection)
+{
+	QStringList texts;
+	if (!ACollection.header.subject.isEmpty())
+		texts.append(ACollection.header.subject);
+	foreach(const Message &message, ACollection.body.messages)
+		if (!message.body().isEmpty())
+			texts.append(message.body());
+	foreach(const QString &note, ACollection.body.notes)
+		if (!note.isEmpty())
+			texts.append(note);
+	return texts;
+}
+
+void DatabaseTaskUpdateTexts::run()
+{
+	QSqlDatabase db = QSqlDatabase::database(databaseConnection());
+	if (db.isOpen())
+	{
+		QSqlQuery insertQuery(db);
+		QSqlQuery insertIndexQuery(db);
+		QSqlQuery removeTextsQuery(db);
+		QSqlQuery removeTextIndexQuery(db);
+		if (!insertQuery.prepare(
+			"INSERT INTO texts (with_node, with_domain, with_resource, start) "
+			"VALUES (:with_n, :with_d, :with_r, :start)"))
+		{
+			setSQLError(insertQuery.lastError());
+		}
+		else if (!insertIndexQuery.prepare(
+			"INSERT INTO texts_fts (docid, body) VALUES (:docid, :body)"))
+		{
+			setSQLError(insertIndexQuery.lastError());
+		}
+		else if (!removeTextIndexQuery.prepare(
+			"DELETE FROM texts_fts WHERE docid IN "
+			"(SELECT id FROM texts WHERE with_node=:with_n AND with_domain=:with_d AND with_resource=:with_r AND start=:start)"))
+		{
+			setSQLError(removeTextIndexQuery.lastError());
+		}
+		else if (!removeTextsQuery.prepare(
+			"DELETE FROM texts WHERE with_node=:with_n AND with_domain=:with_d AND with_resource=:with_r AND start=:start"))
+		{
+			setSQLError(removeTextsQuery.lastError());
+		}
+		else if (!FHeaders.isEmpty())
+		{
+			db.transaction();
+			for (int i=0; i<FHeaders.count(); i++)
+			{
+				const IArchiveHeader &header = FHeaders.at(i);
+				QString start = DateTime(header.start).toX85UTC();
+
+				if (FReplace)
+				{
+					bindQueryValue(removeTextIndexQuery,":with_n",header.with.pNode());
+					bindQueryValue(removeTextIndexQuery,":with_d",header.with.pDomain());
+					bindQueryValue(removeTextIndexQuery,":with_r",header.with.pResource());
+					bindQueryValue(removeTextIndexQuery,":start",start);
+
+					bindQueryValue(removeTextsQuery,":with_n",header.with.pNode());
+					bindQueryValue(removeTextsQuery,":with_d",header.with.pDomain());
+					bindQueryValue(removeTextsQuery,":with_r",header.with.pResource());
+					bindQueryValue(removeTextsQuery,":start",start);
+
+					if (!removeTextIndexQuery.exec())
+					{
+						setSQLError(removeTextIndexQuery.lastError());
+						db.rollback();
+						return;
+					}
+					else if (!removeTextsQuery.exec())
+					{
+						setSQLError(removeTextsQuery.lastError());
+						db.rollback();
+						return;
+					}
+				}
+
+				foreach(const QString &text, FTexts.value(i))
+				{
+					bindQueryValue(insertQuery,":with_n",header.with.pNode());
+					bindQueryValue(insertQuery,":with_d",header.with.pDomain());
+					bindQueryValue(insertQuery,":with_r",header.with.pResource());
+					bindQueryValue(insertQuery,":start",start);
+
+					if (!insertQuery.exec())
+					{
+						setSQLError(insertQuery.lastError());
+						db.rollback();
+						return;
+					}
+
+					// Simple FTS tokenizer folds ASCII letters only
+					bindQueryValue(insertIndexQuery,":docid",insertQuery.lastInsertId());
+					bindQueryValue(insertIndexQuery,":body",text.toLower());
+
+					if (!insertIndexQuery.exec())
+					{
+						setSQLError(insertIndexQuery.lastError());
+						db.rollback();
+						return;
+					}
+				}
 			}
 			db.commit();
 		}
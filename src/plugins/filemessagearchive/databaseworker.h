@@ -29,7 +29,8 @@ public:
 		InsertHeaders,
 		UpdateHeaders,
 		RemoveHeaders,
-		LoadModifications
+		LoadModifications,
+		UpdateTexts
 	};
 public:
 	DatabaseTask(const Jid &AStreamJid, Type AType);
@@ -101,12 +102,13 @@ class DatabaseTaskLoadHeaders :
 	public DatabaseTask
 {
 public:
-	DatabaseTaskLoadHeaders(const Jid &AStreamJid, const IArchiveRequest &ARequest, const QString &AGateType);
+	DatabaseTaskLoadHeaders(const Jid &AStreamJid, const IArchiveRequest &ARequest, const QString &AGateType, quint32 AOffset = 0);
 	IArchiveRequest request() const;
 	QList<DatabaseArchiveHeader> headers() const;
 protected:
 	void run();
 private:
+	quint32 FOffset;
 	QString FGateType;
 	IArchiveRequest FRequest;
 	QList<DatabaseArchiveHeader> FHeaders;
@@ -151,6 +153,21 @@ private:
 	QList<IArchiveHeader> FHeaders;
 };
 
+class DatabaseTaskUpdateTexts :
+	public DatabaseTask
+{
+public:
+	DatabaseTaskUpdateTexts(const Jid &AStreamJid, const QList<IArchiveHeader> &AHeaders, const QList<QStringList> &ATexts, bool AReplace);
+	QList<IArchiveHeader> headers() const;
+	static QStringList collectionTexts(const IArchiveCollection &ACollection);
+protected:
+	void run();
+private:
+	bool FReplace;
+	QList<QStringList> FTexts;
+	QList<IArchiveHeader> FHeaders;
+};
+
 class DatabaseTaskLoadModifications :
 	public DatabaseTask
 {
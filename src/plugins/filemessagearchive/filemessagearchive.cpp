@@ -21,6 +21,8 @@
 
 #define CATEGORY_GATEWAY      "gateway"
 
+#define LOAD_HEADERS_PAGE_SIZE  500
+
 FileMessageArchive::FileMessageArchive() : FMutex(QMutex::Recursive)
 {
 	FPluginManager = NULL;
@@ -223,6 +225,15 @@ bool FileMessageArchive::saveMessage(const Jid &AStreamJid, const Message &AMess
 		{
 			IArchiveItemPrefs prefs = FArchiver->archiveItemPrefs(AStreamJid,itemJid,AMessage.threadId());
 			written = writer->writeMessage(AMessage,prefs.save,ADirectionIn);
+			if (written)
+			{
+				QStringList texts;
+				if (writer->recordsCount()==1 && !writer->header().subject.isEmpty())
+					texts.append(writer->header().subject);
+				if (!AMessage.body().isEmpty())
+					texts.append(AMessage.body());
+				updateTextIndex(AStreamJid,writer->header(),texts,false);
+			}
 		}
 	}
 	else
@@ -251,6 +262,8 @@ bool FileMessageArchive::saveNote(const Jid &AStreamJid, const Message &AMessage
 		if (writer)
 		{
 			written = writer->writeNote(AMessage.body());
+			if (written)
+				updateTextIndex(AStreamJid,writer->header(),QStringList() << AMessage.body(),false);
 		}
 	}
 	else
@@ -308,11 +321,11 @@ QString FileMessageArchive::loadHeaders(const Jid &AStreamJid, const IArchiveReq
 	return QString::null;
 }
 
-QString FileMessageArchive::loadCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader)
+QString FileMessageArchive::loadCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader, int ALastMessages)
 {
 	if (isCapable(AStreamJid,ArchiveManagement) && AHeader.with.isValid() && AHeader.start.isValid())
 	{
-		FileTaskLoadCollection *task = new FileTaskLoadCollection(this,AStreamJid,AHeader);
+		FileTaskLoadCollection *task = new FileTaskLoadCollection(this,AStreamJid,AHeader,ALastMessages);
 		if (FFileWorker->startTask(task))
 		{
 			LOG_STRM_DEBUG(AStreamJid,QString("Load collection task started, id=%1").arg(task->taskId()));
@@ -525,7 +538,7 @@ IArchiveHeader FileMessageArchive::loadFileHeader(const QString &AFilePath) cons
 	return header;
 }
 
-IArchiveCollection FileMessageArchive::loadFileCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader) const
+IArchiveCollection FileMessageArchive::loadFileCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader, int ALastMessages) const
 {
 	IArchiveCollection collection;
 	if (AStreamJid.isValid() && AHeader.with.isValid() && AHeader.start.isValid())
@@ -540,8 +553,36 @@ IArchiveCollection FileMessageArchive::loadFileCollection(const Jid &AStreamJid,
 			{
 				QString xmlError;
 				QDomDocument doc;
-				doc.setContent(&file,true,&xmlError);
-				FArchiver->elementToCollection(AStreamJid,doc.documentElement(),collection);
+				bool loaded = false;
+
+				// Parse only chat element start tag and last messages using offsets written by FileWriter
+				QList<qint64> offsets = ALastMessages>0 ? FileWriter::loadRecordOffsets(filePath) : QList<qint64>();
+				if (offsets.count() > ALastMessages)
+				{
+					QByteArray head = file.read(offsets.first());
+					int chatStart = head.indexOf("<chat");
+					int chatEnd = chatStart>=0 ? head.indexOf('>',chatStart) : -1;
+					if (chatEnd>0 && file.seek(offsets.at(offsets.count()-ALastMessages-1)))
+					{
+						QByteArray data = head.left(chatEnd+1) + file.readAll();
+						if (!data.trimmed().endsWith("</chat>"))
+							data += "</chat>";
+						if (doc.setContent(data,true,&xmlError))
+						{
+							FArchiver->elementToCollection(AStreamJid,doc.documentElement(),collection);
+							loaded = collection.body.messages.count()>=ALastMessages;
+						}
+					}
+					file.seek(0);
+				}
+
+				if (!loaded)
+				{
+					// Index does not match collection file content, fall back to full load
+					collection = IArchiveCollection();
+					doc.setContent(&file,true,&xmlError);
+					FArchiver->elementToCollection(AStreamJid,doc.documentElement(),collection);
+				}
 				if (collection.header.with.isValid() && collection.header.start.isValid())
 					collection.header.engineId = engineId();
 				else
@@ -698,8 +739,10 @@ IArchiveHeader FileMessageArchive::saveFileCollection(const Jid &AStreamJid, con
 			FArchiver->collectionToElement(collection,chatElem,ARCHIVE_SAVE_MESSAGE);
 			file.write(doc.toByteArray());
 			file.close();
+			QFile::remove(FileWriter::indexFileName(file.fileName()));
 
 			saveModification(AStreamJid,collection.header,IArchiveModification::Changed);
+			updateTextIndex(AStreamJid,collection.header,DatabaseTaskUpdateTexts::collectionTexts(collection),true);
 			return collection.header;
 		}
 		else
@@ -723,6 +766,7 @@ bool FileMessageArchive::removeFileCollection(const Jid &AStreamJid, const IArch
 		if (QFile::exists(filePath))
 		{
 			removeFileWriter(findFileWriter(AStreamJid,AHeader));
+			QFile::remove(FileWriter::indexFileName(filePath));
 			if (QFile::remove(filePath))
 			{
 				saveModification(AStreamJid,AHeader,IArchiveModification::Removed);
@@ -807,22 +851,37 @@ QList<IArchiveHeader> FileMessageArchive::loadDatabaseHeaders(const Jid &AStream
 	QList<IArchiveHeader> headers;
 	if (isDatabaseReady(AStreamJid))
 	{
+		// Without full-text index headers are loaded by pages until enough collections matched
+		bool checkFiles = !ARequest.text.isEmpty() && databaseProperty(AStreamJid,FADP_TEXT_INDEX_READY)!="true";
+
 		IArchiveRequest request = ARequest;
-		request.maxItems = request.text.isEmpty() ? request.maxItems : 0xFFFFFFFF;
+		request.text = checkFiles ? QString::null : request.text;
+		request.maxItems = checkFiles ? LOAD_HEADERS_PAGE_SIZE : request.maxItems;
 
-		DatabaseTaskLoadHeaders *task = new DatabaseTaskLoadHeaders(AStreamJid,request,contactGateType(ARequest.with));
-		if (FDatabaseWorker->execTask(task) && !task->isFailed())
+		quint32 offset = 0;
+		QString gateType = contactGateType(ARequest.with);
+		DatabaseTaskLoadHeaders *task = new DatabaseTaskLoadHeaders(AStreamJid,request,gateType,offset);
+		while (FDatabaseWorker->execTask(task) && !task->isFailed())
 		{
-			foreach(const IArchiveHeader &header, task->headers())
+			QList<DatabaseArchiveHeader> pageHeaders = task->headers();
+			foreach(const IArchiveHeader &header, pageHeaders)
 			{
 				if ((quint32)headers.count() >= ARequest.maxItems)
 					break;
-				else if (ARequest.text.isEmpty())
+				else if (!checkFiles)
 					headers.append(header);
 				else if (checkRequestFile(collectionFilePath(AStreamJid,header.with,header.start),ARequest))
 					headers.append(header);
 			}
 
+			if (checkFiles && (quint32)headers.count()<ARequest.maxItems && (quint32)pageHeaders.count()>=request.maxItems)
+			{
+				offset += pageHeaders.count();
+				delete task;
+				task = new DatabaseTaskLoadHeaders(AStreamJid,request,gateType,offset);
+				continue;
+			}
+
 			QMutexLocker locker(&FMutex);
 			int dbHeadersCount = headers.count();
 			foreach(FileWriter *writer, FFileWriters.value(AStreamJid).values())
@@ -836,7 +895,8 @@ QList<IArchiveHeader> FileMessageArchive::loadDatabaseHeaders(const Jid &AStream
 				}
 			}
 
-			if (headers.count() > dbHeadersCount)
+			// Full-text index returns headers ordered by rank
+			if (headers.count()>dbHeadersCount || !request.text.isEmpty())
 			{
 				if (ARequest.order == Qt::AscendingOrder)
 					qSort(headers.begin(),headers.end(),qLess<IArchiveHeader>());
@@ -846,15 +906,13 @@ QList<IArchiveHeader> FileMessageArchive::loadDatabaseHeaders(const Jid &AStream
 				if ((quint32)headers.count() > ARequest.maxItems)
 					headers = headers.mid(0,ARequest.maxItems);
 			}
+			break;
 		}
-		else if (task->isFailed())
-		{
+
+		if (task->isFailed())
 			LOG_STRM_ERROR(AStreamJid,QString("Failed to load database headers: %1").arg(task->error().condition()));
-		}
-		else
-		{
+		else if (!task->isFinished())
 			LOG_STRM_WARNING(AStreamJid,QString("Failed to load database headers: Task not started"));
-		}
 		delete task;
 	}
 	else
@@ -960,7 +1018,7 @@ bool FileMessageArchive::startDatabaseSync(const Jid &AStreamJid, bool AForce)
 			FDatabaseSyncWorker->startSync(AStreamJid);
 			return true;
 		}
-		if (!isDatabaseReady(AStreamJid))
+		if (!isDatabaseReady(AStreamJid) || databaseProperty(AStreamJid,FADP_TEXT_INDEX_READY)!="true")
 		{
 			LOG_STRM_INFO(AStreamJid,"Database synchronization started");
 			FDatabaseSyncWorker->startSync(AStreamJid);
@@ -1173,6 +1231,16 @@ bool FileMessageArchive::saveModification(const Jid &AStreamJid, const IArchiveH
 	return saved;
 }
 
+void FileMessageArchive::updateTextIndex(const Jid &AStreamJid, const IArchiveHeader &AHeader, const QStringList &ATexts, bool AReplace)
+{
+	if (FDatabaseProperties.contains(AStreamJid.bare()) && (AReplace || !ATexts.isEmpty()))
+	{
+		DatabaseTaskUpdateTexts *task = new DatabaseTaskUpdateTexts(AStreamJid,QList<IArchiveHeader>() << AHeader,QList<QStringList>() << ATexts,AReplace);
+		if (!FDatabaseWorker->startTask(task))
+			LOG_STRM_WARNING(AStreamJid,QString("Failed to update text index: Task not started"));
+	}
+}
+
 FileWriter *FileMessageArchive::findFileWriter(const Jid &AStreamJid, const IArchiveHeader &AHeader) const
 {
 	QMutexLocker locker(&FMutex);
@@ -1234,9 +1302,14 @@ void FileMessageArchive::removeFileWriter(FileWriter *AWriter)
 		FWritingFiles.remove(AWriter->fileName());
 		FFileWriters[AWriter->streamJid()].remove(AWriter->header().with,AWriter);
 		if (AWriter->messagesCount() > 0)
+		{
 			saveModification(AWriter->streamJid(),AWriter->header(),IArchiveModification::Changed);
+		}
 		else
+		{
 			QFile::remove(AWriter->fileName());
+			QFile::remove(FileWriter::indexFileName(AWriter->fileName()));
+		}
 	}
 }
 
@@ -1338,6 +1411,7 @@ void FileMessageArchive::onDatabaseSyncFinished(const Jid &AStreamJid, bool AFai
 		LOG_STRM_INFO(AStreamJid,"Database synchronization finished");
 		quint32 caps = capabilities(AStreamJid);
 		setDatabaseProperty(AStreamJid,FADP_LAST_SYNC_TIME,DateTime(QDateTime::currentDateTime()).toX85UTC());
+		setDatabaseProperty(AStreamJid,FADP_TEXT_INDEX_READY,"true");
 		if (caps != capabilities(AStreamJid))
 			emit capabilitiesChanged(AStreamJid);
 	}
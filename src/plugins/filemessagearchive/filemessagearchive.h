@@ -43,7 +43,7 @@ public:
 	virtual bool saveNote(const Jid &AStreamJid, const Message &AMessage, bool ADirectionIn);
 	virtual QString saveCollection(const Jid &AStreamJid, const IArchiveCollection &ACollection);
 	virtual QString loadHeaders(const Jid &AStreamJid, const IArchiveRequest &ARequest);
-	virtual QString loadCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader);
+	virtual QString loadCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader, int ALastMessages = -1);
 	virtual QString removeCollections(const Jid &AStreamJid, const IArchiveRequest &ARequest);
 	virtual QString loadModifications(const Jid &AStreamJid, const QDateTime &AStart, int ACount, const QString &ANextRef);
 	//IFileMessageArchive
@@ -55,7 +55,7 @@ public:
 	virtual QString collectionDirPath(const Jid &AStreamJid, const Jid &AWith) const;
 	virtual QString collectionFilePath(const Jid &AStreamJid, const Jid &AWith, const QDateTime &AStart) const;
 	virtual IArchiveHeader loadFileHeader(const QString &AFilePath) const;
-	virtual IArchiveCollection loadFileCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader) const;
+	virtual IArchiveCollection loadFileCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader, int ALastMessages = -1) const;
 	virtual QList<IArchiveHeader> loadFileHeaders(const Jid &AStreamJid, const IArchiveRequest &ARequest) const;
 	virtual IArchiveHeader saveFileCollection(const Jid &AStreamJid, const IArchiveCollection &ACollection);
 	virtual bool removeFileCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader);
@@ -91,6 +91,7 @@ protected:
 	bool checkRequestHeader(const IArchiveHeader &AHeader, const IArchiveRequest &ARequest) const;
 	bool checkRequestFile(const QString &AFileName, const IArchiveRequest &ARequest, IArchiveHeader *AHeader=NULL) const;
 	bool saveModification(const Jid &AStreamJid, const IArchiveHeader &AHeader, IArchiveModification::ModifyAction AAction);
+	void updateTextIndex(const Jid &AStreamJid, const IArchiveHeader &AHeader, const QStringList &ATexts, bool AReplace);
 protected:
 	FileWriter *findFileWriter(const Jid &AStreamJid, const IArchiveHeader &AHeader) const;
 	FileWriter *findFileWriter(const Jid &AStreamJid, const Jid &AWith, const QString &AThreadId) const;
@@ -83,9 +83,10 @@ void FileTaskSaveCollection::run()
 }
 
 // FileTaskLoadCollection
-FileTaskLoadCollection::FileTaskLoadCollection(IFileMessageArchive *AArchive, const Jid &AStreamJid, const IArchiveHeader &AHeader) : FileTask(AArchive,AStreamJid,LoadCollection)
+FileTaskLoadCollection::FileTaskLoadCollection(IFileMessageArchive *AArchive, const Jid &AStreamJid, const IArchiveHeader &AHeader, int ALastMessages) : FileTask(AArchive,AStreamJid,LoadCollection)
 {
 	FHeader = AHeader;
+	FLastMessages = ALastMessages;
 }
 
 IArchiveCollection FileTaskLoadCollection::archiveCollection() const
@@ -95,7 +96,7 @@ IArchiveCollection FileTaskLoadCollection::archiveCollection() const
 
 void FileTaskLoadCollection::run()
 {
-	FCollection = FFileArchive->loadFileCollection(FStreamJid,FHeader);
+	FCollection = FFileArchive->loadFileCollection(FStreamJid,FHeader,FLastMessages);
 	if (!FCollection.header.with.isValid() || !FCollection.header.start.isValid())
 		FError = XmppError(IERR_HISTORY_CONVERSATION_LOAD_ERROR);
 }
@@ -68,11 +68,12 @@ class FileTaskLoadCollection :
 	public FileTask
 {
 public:
-	FileTaskLoadCollection(IFileMessageArchive *AArchive, const Jid &AStreamJid, const IArchiveHeader &AHeader);
+	FileTaskLoadCollection(IFileMessageArchive *AArchive, const Jid &AStreamJid, const IArchiveHeader &AHeader, int ALastMessages = -1);
 	IArchiveCollection archiveCollection() const;
 protected:
 	void run();
 private:
+	int FLastMessages;
 	IArchiveHeader FHeader;
 	IArchiveCollection FCollection;
 };
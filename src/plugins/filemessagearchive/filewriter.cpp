@@ -1,5 +1,6 @@
 #include "filewriter.h"
 
+#include <QDataStream>
 #include <definitions/namespaces.h>
 #include <definitions/optionvalues.h>
 #include <utils/datetime.h>
@@ -15,6 +16,7 @@
 FileWriter::FileWriter(const Jid &AStreamJid, const QString &AFileName, const IArchiveHeader &AHeader, QObject *AParent) : QObject(AParent)
 {
 	FXmlFile = NULL;
+	FIndexFile = NULL;
 	FXmlWriter = NULL;
 
 	FGroupchat = false;
@@ -34,6 +36,21 @@ FileWriter::FileWriter(const Jid &AStreamJid, const QString &AFileName, const IA
 		if (FXmlFile->open(QIODevice::WriteOnly|QIODevice::Truncate))
 		{
 			FXmlWriter = new QXmlStreamWriter(FXmlFile);
+
+			// Offsets of written messages allow to load last messages without parsing whole file
+			FIndexFile = new QFile(indexFileName(FFileName),this);
+			if (FIndexFile->open(QIODevice::WriteOnly|QIODevice::Truncate))
+			{
+				QDataStream stream(FIndexFile);
+				stream << (quint32)COLLECTION_INDEX_MAGIC << (quint32)COLLECTION_INDEX_VERSION;
+			}
+			else
+			{
+				LOG_WARNING(QString("Failed to create file writer index %1: %2").arg(FIndexFile->fileName(),FIndexFile->errorString()));
+				delete FIndexFile;
+				FIndexFile = NULL;
+			}
+
 			startCollection();
 		}
 		else
@@ -118,6 +135,7 @@ bool FileWriter::writeMessage(const Message &AMessage, const QString &ASaveMode,
 			FXmlWriter->writeEndElement();
 			FXmlFile->flush();
 
+			writeRecordOffset();
 			checkLimits();
 			return true;
 		}
@@ -147,6 +165,41 @@ void FileWriter::closeAndDeleteLater()
 	deleteLater();
 }
 
+QString FileWriter::indexFileName(const QString &AFileName)
+{
+	return AFileName + COLLECTION_INDEX_EXT;
+}
+
+QList<qint64> FileWriter::loadRecordOffsets(const QString &AFileName)
+{
+	QList<qint64> offsets;
+
+	QFile file(indexFileName(AFileName));
+	if (file.open(QIODevice::ReadOnly))
+	{
+		quint32 magic, version;
+		QDataStream stream(&file);
+		stream >> magic >> version;
+		if (magic==COLLECTION_INDEX_MAGIC && version==COLLECTION_INDEX_VERSION)
+		{
+			qint64 fileSize = QFile(AFileName).size();
+			while (!stream.atEnd())
+			{
+				qint64 offset;
+				stream >> offset;
+				if (stream.status()!=QDataStream::Ok || offset>fileSize || (!offsets.isEmpty() && offset<=offsets.last()))
+				{
+					offsets.clear();
+					break;
+				}
+				offsets.append(offset);
+			}
+		}
+	}
+
+	return offsets;
+}
+
 void FileWriter::startCollection()
 {
 	FXmlWriter->setAutoFormatting(true);
@@ -177,6 +230,12 @@ void FileWriter::stopCollection()
 		FXmlFile->deleteLater();
 		FXmlFile = NULL;
 	}
+	if (FIndexFile)
+	{
+		FIndexFile->close();
+		FIndexFile->deleteLater();
+		FIndexFile = NULL;
+	}
 }
 
 void FileWriter::writeElementChilds(const QDomElement &AParent)
@@ -215,6 +274,16 @@ void FileWriter::writeElementChilds(const QDomElement &AParent)
 	}
 }
 
+void FileWriter::writeRecordOffset()
+{
+	if (FIndexFile)
+	{
+		QDataStream stream(FIndexFile);
+		stream << FXmlFile->pos();
+		FIndexFile->flush();
+	}
+}
+
 void FileWriter::checkLimits()
 {
 	if (FXmlFile->size() > Options::node(OPV_FILEARCHIVE_COLLECTION_CRITICALSIZE).value().toInt())
@@ -6,6 +6,10 @@
 #include <QXmlStreamWriter>
 #include <interfaces/imessagearchiver.h>
 
+#define COLLECTION_INDEX_EXT     ".idx"
+#define COLLECTION_INDEX_MAGIC   0x56434F49
+#define COLLECTION_INDEX_VERSION 2
+
 class FileWriter :
 	public QObject
 {
@@ -23,15 +27,19 @@ public:
 	bool writeMessage(const Message &AMessage, const QString &ASaveMode, bool ADirectionIn);
 	bool writeNote(const QString &ANote);
 	void closeAndDeleteLater();
+	static QString indexFileName(const QString &AFileName);
+	static QList<qint64> loadRecordOffsets(const QString &AFileName);
 signals:
 	void writerDestroyed(FileWriter *AWriter);
 protected:
 	void startCollection();
 	void stopCollection();
 	void writeElementChilds(const QDomElement &AElem);
+	void writeRecordOffset();
 	void checkLimits();
 private:
 	QFile *FXmlFile;
+	QFile *FIndexFile;
 	QTimer FCloseTimer;
 	QXmlStreamWriter *FXmlWriter;
 private:
@@ -11,15 +11,19 @@
 
 #define CONNECTION_TIMEOUT 60000
 
-FileStream::FileStream(IDataStreamsManager *ADataManager, const QString &AStreamId, const Jid &AStreamJid, const Jid &AContactJid, int AKind, QObject *AParent) : QObject(AParent)
+QHash<QString, QPair<QDateTime,QString> > FileStream::FHashCache;
+
+FileStream::FileStream(IDataStreamsManager *ADataManager, IFileStreamsManager *AFileManager, const QString &AStreamId, const Jid &AStreamJid, const Jid &AContactJid, int AKind, QObject *AParent) : QObject(AParent)
 {
 	FStreamId = AStreamId;
 	FStreamJid = AStreamJid;
 	FContactJid= AContactJid;
 	FStreamKind = AKind;
 	FDataManager = ADataManager;
+	FFileManager = AFileManager;
 
 	FThread = NULL;
+	FHashThread = NULL;
 	FSocket = NULL;
 
 	FAborted = false;
@@ -27,6 +31,7 @@ FileStream::FileStream(IDataStreamsManager *ADataManager, const QString &AStream
 	FFileSize = 0;
 	FRangeOffset = 0;
 	FRangeLength = 0;
+	FPartialSize = -1;
 	FSpeedIndex = 0;
 	FRangeSupported = AKind==IFileStream::SendFile;
 	FStreamState = IFileStream::Creating;
@@ -38,13 +43,23 @@ FileStream::~FileStream()
 	{
 		FThread->abort();
 		FThread->wait();
+		updateTransferHash();
 		delete FThread;
 		FThread = NULL;
 	}
+	if (FHashThread)
+	{
+		delete FHashThread;
+		FHashThread = NULL;
+	}
 	if (FSocket)
 	{
 		delete FSocket->instance();
 	}
+	if (FStreamState!=Finished && FStreamState!=Aborted)
+	{
+		updatePartialTransfer();
+	}
 	emit streamDestroyed();
 }
 
@@ -279,15 +294,24 @@ bool FileStream::initStream(const QList<QString> &AMethods)
 	{
 		if (updateFileInfo() && !FFileName.isEmpty() && FFileSize>0)
 		{
-			if (FDataManager->initStream(FStreamId,FStreamJid,FContactJid,NS_SI_FILETRANSFER,AMethods))
-			{
-				setStreamState(Negotiating,tr("Waiting for a response to send a file request"));
-				return true;
-			}
-			else
+			FInitMethods = AMethods;
+
+			// Hash of unchanged file is calculated only once
+			QFileInfo finfo(FFileName);
+			QPair<QDateTime,QString> cachedHash = FHashCache.value(finfo.absoluteFilePath());
+			if (cachedHash.first.isValid() && cachedHash.first==finfo.lastModified())
 			{
-				LOG_STRM_WARNING(FStreamJid,QString("Failed to init file stream, sid=%1: Request not sent").arg(FStreamId));
+				FFileHash = cachedHash.second;
+				return sendInitRequest();
 			}
+
+			// Request is sent after hash is calculated to allow receiver to verify the file
+			FFileHash.clear();
+			FHashThread = new HashThread(finfo.absoluteFilePath(),this);
+			connect(FHashThread,SIGNAL(finished()),SLOT(onHashThreadFinished()));
+			setStreamState(Negotiating,tr("Calculating file checksum"));
+			FHashThread->start();
+			return true;
 		}
 		else
 		{
@@ -334,6 +358,7 @@ bool FileStream::startStream(const QString &AMethodNS)
 	}
 	else if (FStreamKind==ReceiveFile && FStreamState==Creating)
 	{
+		loadPartialTransfer();
 		if (openFile())
 		{
 			if (FDataManager->acceptStream(FStreamId,AMethodNS))
@@ -385,6 +410,10 @@ void FileStream::abortStream(const XmppError &AError)
 			FError = AError;
 			LOG_STRM_WARNING(FStreamJid,QString("Aborting file stream, sid=%1: %2").arg(FStreamId,AError.condition()));
 		}
+		if (FHashThread)
+		{
+			FHashThread->abort();
+		}
 		if (FThread && FThread->isRunning())
 		{
 			FThread->abort();
@@ -433,6 +462,9 @@ bool FileStream::openFile()
 			}
 			if (FFile.open(mode))
 			{
+				// Data after the verified part of partial file will be received again
+				if (FStreamKind==IFileStream::ReceiveFile && FFile.size()>FRangeOffset)
+					FFile.resize(FRangeOffset);
 				if (FRangeOffset==0 || FFile.seek(FRangeOffset))
 					return true;
 				if (FStreamKind == IFileStream::ReceiveFile)
@@ -481,6 +513,20 @@ bool FileStream::updateFileInfo()
 	return true;
 }
 
+bool FileStream::sendInitRequest()
+{
+	if (FDataManager->initStream(FStreamId,FStreamJid,FContactJid,NS_SI_FILETRANSFER,FInitMethods))
+	{
+		setStreamState(Negotiating,tr("Waiting for a response to send a file request"));
+		return true;
+	}
+	else
+	{
+		LOG_STRM_WARNING(FStreamJid,QString("Failed to init file stream, sid=%1: Request not sent").arg(FStreamId));
+	}
+	return false;
+}
+
 void FileStream::setStreamState(int AState, const QString &AMessage)
 {
 	if (FStreamState != AState)
@@ -506,10 +552,75 @@ void FileStream::setStreamState(int AState, const QString &AMessage)
 
 		FStreamState = AState;
 		FStateString = AMessage;
+
+		if (AState==Finished || AState==Aborted)
+			updatePartialTransfer();
+
+		emit stateChanged();
+	}
+	else if (FStateString != AMessage)
+	{
+		FStateString = AMessage;
 		emit stateChanged();
 	}
 }
 
+void FileStream::updateTransferHash()
+{
+	if (FThread != NULL)
+	{
+		FTransferHash = FThread->fileHash();
+		if (FStreamKind==SendFile && !FTransferHash.isEmpty())
+		{
+			QFileInfo finfo(FFileName);
+			FHashCache.insert(finfo.absoluteFilePath(),qMakePair(finfo.lastModified(),FTransferHash));
+		}
+		else if (FStreamKind == ReceiveFile)
+		{
+			FPartialSize = FThread->partialSize();
+			FPartialHash = FThread->partialHash();
+		}
+	}
+}
+
+void FileStream::loadPartialTransfer()
+{
+	FPrefixHash.clear();
+	if (FFileManager!=NULL && FRangeSupported && FRangeOffset>0)
+	{
+		// Resume from the part of file that was received and hashed before interruption
+		IPartialFileTransfer transfer = FFileManager->findPartialTransfer(FContactJid,FFileName,FFileSize,FFileHash);
+		if (!transfer.isNull() && transfer.receivedSize<=FRangeOffset)
+		{
+			LOG_STRM_INFO(FStreamJid,QString("Resuming partial file transfer, sid=%1, offset=%2").arg(FStreamId).arg(transfer.receivedSize));
+			FPrefixHash = transfer.receivedHash;
+			setRangeOffset(transfer.receivedSize);
+		}
+	}
+}
+
+void FileStream::updatePartialTransfer()
+{
+	if (FFileManager!=NULL && FStreamKind==ReceiveFile && FPartialSize>=0)
+	{
+		if (FStreamState!=Finished && FRangeSupported && !FFileHash.isEmpty() && FPartialSize>0 && FPartialSize<FFileSize && !FPartialHash.isEmpty())
+		{
+			IPartialFileTransfer transfer;
+			transfer.contactJid = FContactJid.bare();
+			transfer.fileName = FFileName;
+			transfer.fileSize = FFileSize;
+			transfer.fileHash = FFileHash;
+			transfer.receivedSize = FPartialSize;
+			transfer.receivedHash = FPartialHash;
+			FFileManager->insertPartialTransfer(transfer);
+		}
+		else
+		{
+			FFileManager->removePartialTransfer(FFileName);
+		}
+	}
+}
+
 void FileStream::onSocketStateChanged(int AState)
 {
 	if (AState == IDataStreamSocket::Opening)
@@ -522,7 +633,11 @@ void FileStream::onSocketStateChanged(int AState)
 		{
 			LOG_STRM_DEBUG(FStreamJid,QString("Starting file stream thread, sid=%1").arg(FStreamId));
 			qint64 bytesForTransfer = FRangeLength>0 ? FRangeLength : FFileSize-FRangeOffset;
-			FThread = new TransferThread(FSocket,&FFile,FStreamKind,bytesForTransfer,this);
+			// Received data and existing file prefix are hashed only to verify them against the sender hash
+			bool calcHash = FStreamKind==SendFile ? FRangeOffset==0 && bytesForTransfer==FFileSize && FFileHash.isEmpty() : !FFileHash.isEmpty();
+			FThread = new TransferThread(FSocket,&FFile,FStreamKind,bytesForTransfer,calcHash,this);
+			if (FStreamKind==ReceiveFile && FRangeOffset>0)
+				FThread->setHashPrefix(FRangeOffset,FPrefixHash);
 			connect(FThread,SIGNAL(transferProgress(qint64)),SLOT(onTransferThreadProgress(qint64)));
 			connect(FThread,SIGNAL(finished()),SLOT(onTransferThreadFinished()));
 			setStreamState(Transfering,tr("Data transmission"));
@@ -535,6 +650,7 @@ void FileStream::onSocketStateChanged(int AState)
 		{
 			FThread->abort();
 			FThread->wait();
+			updateTransferHash();
 		}
 		if (!FAborted)
 		{
@@ -547,8 +663,15 @@ void FileStream::onSocketStateChanged(int AState)
 			{
 				abortStream(FSocket->error());
 			}
+			else if (FProgress==bytesForTransfer && FStreamKind==ReceiveFile && FRangeOffset+bytesForTransfer==FFileSize && !FFileHash.isEmpty() && !FTransferHash.isEmpty() && FTransferHash!=FFileHash.toLower())
+			{
+				LOG_STRM_WARNING(FStreamJid,QString("Received file hash mismatch, sid=%1, expected=%2, received=%3").arg(FStreamId,FFileHash,FTransferHash));
+				abortStream(XmppError(IERR_FILESTREAMS_STREAM_FILE_HASH_MISMATCH));
+			}
 			else if (FProgress == bytesForTransfer)
 			{
+				if (FStreamKind==ReceiveFile && FTransferHash.isEmpty())
+					LOG_STRM_INFO(FStreamJid,QString("Received file is unverified, sid=%1, expected=%2").arg(FStreamId,FFileHash));
 				setStreamState(Finished,tr("Data transmission finished"));
 			}
 			else
@@ -575,6 +698,12 @@ void FileStream::onTransferThreadProgress(qint64 ABytes)
 void FileStream::onTransferThreadFinished()
 {
 	LOG_STRM_DEBUG(FStreamJid,QString("File stream thread finished, sid=%1").arg(FStreamId));
+	updateTransferHash();
+	if (!FThread->isPrefixValid())
+	{
+		LOG_STRM_WARNING(FStreamJid,QString("Partially received file was changed, sid=%1").arg(FStreamId));
+		abortStream(XmppError(IERR_FILESTREAMS_STREAM_FILE_HASH_MISMATCH));
+	}
 	if (FSocket && FSocket->isOpen())
 	{
 		setStreamState(Disconnecting,tr("Disconnecting"));
@@ -584,6 +713,31 @@ void FileStream::onTransferThreadFinished()
 	FThread = NULL;
 }
 
+void FileStream::onHashThreadFinished()
+{
+	QString fileHash = FHashThread->fileHash();
+	FHashThread->deleteLater();
+	FHashThread = NULL;
+
+	if (!FAborted && FStreamState==Negotiating)
+	{
+		if (!fileHash.isEmpty())
+		{
+			LOG_STRM_DEBUG(FStreamJid,QString("File hash calculated, sid=%1, hash=%2").arg(FStreamId,fileHash));
+			QFileInfo finfo(FFileName);
+			FFileHash = fileHash;
+			FHashCache.insert(finfo.absoluteFilePath(),qMakePair(finfo.lastModified(),FFileHash));
+		}
+		else
+		{
+			LOG_STRM_WARNING(FStreamJid,QString("Failed to calculate file hash, sid=%1").arg(FStreamId));
+		}
+
+		if (!sendInitRequest())
+			abortStream(XmppError(IERR_FILESTREAMS_STREAM_REQUEST_NOT_SENT));
+	}
+}
+
 void FileStream::onIncrementSpeedIndex()
 {
 	if (FStreamState == Transfering)
@@ -591,6 +745,14 @@ void FileStream::onIncrementSpeedIndex()
 	FSpeedIndex = (FSpeedIndex+1) % SPEED_POINTS;
 	FSpeed[FSpeedIndex] = 0;
 	emit speedChanged();
+
+	// Journal is updated periodically to allow resume after application crash
+	if (FSpeedIndex==0 && FStreamState==Transfering && FStreamKind==ReceiveFile && FThread!=NULL)
+	{
+		FPartialSize = FThread->partialSize();
+		FPartialHash = FThread->partialHash();
+		updatePartialTransfer();
+	}
 }
 
 void FileStream::onConnectionTimeout()
@@ -2,9 +2,12 @@
 #define FILESTREAM_H
 
 #include <QFile>
+#include <QHash>
+#include <QPair>
 #include <interfaces/ifilestreamsmanager.h>
 #include <interfaces/idatastreamsmanager.h>
 #include "transferthread.h"
+#include "hashthread.h"
 
 #define SPEED_POINTS      10
 #define SPEED_INTERVAL    500
@@ -16,7 +19,7 @@ class FileStream :
 	Q_OBJECT;
 	Q_INTERFACES(IFileStream);
 public:
-	FileStream(IDataStreamsManager *ADataManager, const QString &AStreamId, const Jid &AStreamJid, const Jid &AContactJid, int AKind, QObject *AParent);
+	FileStream(IDataStreamsManager *ADataManager, IFileStreamsManager *AFileManager, const QString &AStreamId, const Jid &AStreamJid, const Jid &AContactJid, int AKind, QObject *AParent);
 	~FileStream();
 	virtual QObject *instance() { return this; }
 	virtual QString streamId() const;
@@ -61,15 +64,21 @@ signals:
 protected:
 	bool openFile();
 	bool updateFileInfo();
+	bool sendInitRequest();
 	void setStreamState(int AState, const QString &AMessage);
+	void updateTransferHash();
+	void loadPartialTransfer();
+	void updatePartialTransfer();
 protected slots:
 	void onSocketStateChanged(int AState);
 	void onTransferThreadProgress(qint64 ABytes);
 	void onTransferThreadFinished();
+	void onHashThreadFinished();
 	void onIncrementSpeedIndex();
 	void onConnectionTimeout();
 private:
 	IDataStreamsManager *FDataManager;
+	IFileStreamsManager *FFileManager;
 private:
 	QString FStreamId;
 	Jid FStreamJid;
@@ -84,6 +93,7 @@ private:
 	XmppError FError;
 	QString FStateString;
 	QStringList FAcceptableMethods;
+	QList<QString> FInitMethods;
 private:
 	bool FRangeSupported;
 	qint64 FRangeOffset;
@@ -95,8 +105,15 @@ private:
 	QDateTime FFileDate;
 private:
 	QFile FFile;
+	QString FTransferHash;
+	QString FPrefixHash;
+	qint64 FPartialSize;
+	QString FPartialHash;
 	TransferThread *FThread;
+	HashThread *FHashThread;
 	IDataStreamSocket *FSocket;
+private:
+	static QHash<QString, QPair<QDateTime,QString> > FHashCache;
 };
 
 #endif // FILESTREAM_H
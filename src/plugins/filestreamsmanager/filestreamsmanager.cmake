@@ -1,3 +1,3 @@
-set(SOURCES transferthread.cpp filestreamswindow.cpp filestreamsoptionswidget.cpp filestreamsmanager.cpp filestream.cpp )
-set(HEADERS transferthread.h filestreamswindow.h filestreamsoptionswidget.h filestream.h filestreamsmanager.h )
+set(SOURCES transferthread.cpp hashthread.cpp filestreamswindow.cpp filestreamsoptionswidget.cpp filestreamsmanager.cpp filestream.cpp )
+set(HEADERS transferthread.h hashthread.h filestreamswindow.h filestreamsoptionswidget.h filestream.h filestreamsmanager.h )
 set(UIS filestreamswindow.ui filestreamsoptionswidget.ui )
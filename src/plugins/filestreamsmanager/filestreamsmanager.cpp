@@ -2,7 +2,9 @@
 
 #include <QSet>
 #include <QDir>
+#include <QFileInfo>
 #include <QComboBox>
+#include <QDataStream>
 #include <QDesktopServices>
 #include <definitions/namespaces.h>
 #include <definitions/menuicons.h>
@@ -19,10 +21,15 @@
 #include <utils/shortcuts.h>
 #include <utils/datetime.h>
 #include <utils/options.h>
+#include <utils/savefiletask.h>
 #include <utils/stanza.h>
 #include <utils/logger.h>
 #include <utils/jid.h>
 
+#define PARTIAL_TRANSFERS_FILE_NAME      "filetransfers.dat"
+#define PARTIAL_TRANSFERS_FILE_MAGIC     0x46545054
+#define PARTIAL_TRANSFERS_FILE_VERSION   1
+
 FileStreamsManager::FileStreamsManager()
 {
 	FDataManager = NULL;
@@ -49,6 +56,7 @@ void FileStreamsManager::pluginInfo(IPluginInfo *APluginInfo)
 bool FileStreamsManager::initConnections(IPluginManager *APluginManager, int &AInitOrder)
 {
 	Q_UNUSED(AInitOrder);
+
 	IPlugin *plugin = APluginManager->pluginInterface("IDataStreamsManager").value(0,NULL);
 	if (plugin)
 	{
@@ -73,6 +81,7 @@ bool FileStreamsManager::initConnections(IPluginManager *APluginManager, int &AI
 		FOptionsManager = qobject_cast<IOptionsManager *>(plugin->instance());
 		if (FOptionsManager)
 		{
+			connect(FOptionsManager->instance(),SIGNAL(profileOpened(const QString &)),SLOT(onProfileOpened(const QString &)));
 			connect(FOptionsManager->instance(),SIGNAL(profileClosed(const QString &)),SLOT(onProfileClosed(const QString &)));
 		}
 	}
@@ -86,7 +95,9 @@ bool FileStreamsManager::initObjects()
 
 	XmppError::registerError(NS_INTERNAL_ERROR,IERR_FILESTREAMS_STREAM_FILE_IO_ERROR,tr("File input/output error"));
 	XmppError::registerError(NS_INTERNAL_ERROR,IERR_FILESTREAMS_STREAM_FILE_SIZE_CHANGED,tr("File size unexpectedly changed"));
+	XmppError::registerError(NS_INTERNAL_ERROR,IERR_FILESTREAMS_STREAM_FILE_HASH_MISMATCH,tr("Received file is corrupted, checksum mismatch"));
 	XmppError::registerError(NS_INTERNAL_ERROR,IERR_FILESTREAMS_STREAM_CONNECTION_TIMEOUT,tr("Connection timed out"));
+	XmppError::registerError(NS_INTERNAL_ERROR,IERR_FILESTREAMS_STREAM_REQUEST_NOT_SENT,tr("Failed to send file transfer request"));
 	XmppError::registerError(NS_INTERNAL_ERROR,IERR_FILESTREAMS_STREAM_TERMINATED_BY_REMOTE_USER,tr("Data transmission terminated by remote user"));
 
 	if (FDataManager)
@@ -108,7 +119,7 @@ bool FileStreamsManager::initObjects()
 		if (FTrayManager)
 			FTrayManager->contextMenu()->addAction(action, AG_TMTM_FILESTREAMS_TRANSFER, true);
 	}
-	
+
 	return true;
 }
 
@@ -305,7 +316,7 @@ IFileStream *FileStreamsManager::createStream(IFileStreamHandler *AHandler, cons
 	{
 		LOG_STRM_INFO(AStreamJid,QString("Creating file stream, sid=%1, with=%2, kind=%3").arg(AStreamId,AContactJid.full()).arg(AKind));
 		
-		IFileStream *stream = new FileStream(FDataManager,AStreamId,AStreamJid,AContactJid,AKind,AParent);
+		IFileStream *stream = new FileStream(FDataManager,this,AStreamId,AStreamJid,AContactJid,AKind,AParent);
 		connect(stream->instance(),SIGNAL(streamDestroyed()),SLOT(onStreamDestroyed()));
 		
 		FStreams.insert(AStreamId,stream);
@@ -345,6 +356,129 @@ void FileStreamsManager::removeStreamsHandler(int AOrder, IFileStreamHandler *AH
 	}
 }
 
+QList<IPartialFileTransfer> FileStreamsManager::partialTransfers() const
+{
+	return FPartialTransfers.values();
+}
+
+IPartialFileTransfer FileStreamsManager::findPartialTransfer(const Jid &AContactJid, const QString &AFileName, qint64 AFileSize, const QString &AFileHash) const
+{
+	// Without sender hash another file with the same name and size can not be told apart
+	IPartialFileTransfer transfer = FPartialTransfers.value(QFileInfo(AFileName).absoluteFilePath());
+	if (!transfer.isNull() && !AFileHash.isEmpty() && transfer.contactJid.pBare()==AContactJid.pBare() && transfer.fileSize==AFileSize && transfer.fileHash.toLower()==AFileHash.toLower())
+	{
+		// Partial file could be truncated or removed after transfer was interrupted
+		if (QFileInfo(transfer.fileName).size() >= transfer.receivedSize)
+			return transfer;
+	}
+	return IPartialFileTransfer();
+}
+
+void FileStreamsManager::insertPartialTransfer(const IPartialFileTransfer &ATransfer)
+{
+	if (!ATransfer.isNull() && !ATransfer.fileHash.isEmpty() && ATransfer.receivedSize>0 && ATransfer.receivedSize<ATransfer.fileSize)
+	{
+		IPartialFileTransfer transfer = ATransfer;
+		transfer.fileName = QFileInfo(ATransfer.fileName).absoluteFilePath();
+		LOG_INFO(QString("Partial file transfer saved, file=%1, received=%2, size=%3").arg(transfer.fileName).arg(transfer.receivedSize).arg(transfer.fileSize));
+
+		FPartialTransfers.insert(transfer.fileName,transfer);
+		savePartialTransfers();
+		emit partialTransfersChanged();
+	}
+}
+
+void FileStreamsManager::removePartialTransfer(const QString &AFileName)
+{
+	if (FPartialTransfers.remove(QFileInfo(AFileName).absoluteFilePath()) > 0)
+	{
+		LOG_INFO(QString("Partial file transfer removed, file=%1").arg(AFileName));
+		savePartialTransfers();
+		emit partialTransfersChanged();
+	}
+}
+
+QString FileStreamsManager::partialTransfersFileName() const
+{
+	if (FOptionsManager!=NULL && FOptionsManager->isOpened())
+		return QDir(FOptionsManager->profilePath(FOptionsManager->currentProfile())).absoluteFilePath(PARTIAL_TRANSFERS_FILE_NAME);
+	return QString::null;
+}
+
+void FileStreamsManager::loadPartialTransfers()
+{
+	QFile file(partialTransfersFileName());
+	if (file.open(QIODevice::ReadOnly))
+	{
+		quint32 magic = 0;
+		quint32 version = 0;
+		QDataStream stream(&file);
+		stream >> magic >> version;
+		if (magic==PARTIAL_TRANSFERS_FILE_MAGIC && version==PARTIAL_TRANSFERS_FILE_VERSION)
+		{
+			quint32 count = 0;
+			stream >> count;
+
+			QMap<QString, IPartialFileTransfer> transfers;
+			for (quint32 i=0; i<count && stream.status()==QDataStream::Ok; i++)
+			{
+				QString contactJid;
+				IPartialFileTransfer transfer;
+				stream >> contactJid >> transfer.fileName >> transfer.fileSize >> transfer.fileHash >> transfer.receivedSize >> transfer.receivedHash;
+				transfer.contactJid = contactJid;
+
+				// Skip transfers whose partial files were removed by user
+				if (QFileInfo(transfer.fileName).size() >= transfer.receivedSize)
+					transfers.insert(transfer.fileName,transfer);
+			}
+
+			if (stream.status() == QDataStream::Ok)
+			{
+				LOG_INFO(QString("Partial file transfers loaded, count=%1").arg(transfers.count()));
+				FPartialTransfers = transfers;
+			}
+			else
+			{
+				REPORT_ERROR("Failed to load partial file transfers from file content: Invalid data");
+				file.remove();
+			}
+		}
+		else
+		{
+			REPORT_ERROR("Failed to load partial file transfers from file content: Invalid format");
+			file.remove();
+		}
+	}
+	else if (file.exists())
+	{
+		REPORT_ERROR(QString("Failed to load partial file transfers from file: %1").arg(file.errorString()));
+	}
+}
+
+void FileStreamsManager::savePartialTransfers() const
+{
+	QFile file(partialTransfersFileName());
+	if (file.fileName().isEmpty())
+	{
+		LOG_WARNING("Failed to save partial file transfers: Profile not opened");
+	}
+	else if (!FPartialTransfers.isEmpty())
+	{
+		QByteArray data;
+		QDataStream stream(&data,QIODevice::WriteOnly);
+		stream << (quint32)PARTIAL_TRANSFERS_FILE_MAGIC << (quint32)PARTIAL_TRANSFERS_FILE_VERSION;
+		stream << (quint32)FPartialTransfers.count();
+		foreach(const IPartialFileTransfer &transfer, FPartialTransfers)
+			stream << transfer.contactJid.bare() << transfer.fileName << transfer.fileSize << transfer.fileHash << transfer.receivedSize << transfer.receivedHash;
+
+		SaveFileTask::saveFile(file.fileName(),data);
+	}
+	else if (file.exists())
+	{
+		file.remove();
+	}
+}
+
 void FileStreamsManager::onStreamDestroyed()
 {
 	IFileStream *stream = qobject_cast<IFileStream *>(sender());
@@ -367,6 +501,13 @@ void FileStreamsManager::onShowFileStreamsWindow(bool)
 	WidgetManager::showActivateRaiseWindow(FFileStreamsWindow);
 }
 
+void FileStreamsManager::onProfileOpened(const QString &AName)
+{
+	Q_UNUSED(AName);
+	loadPartialTransfers();
+	emit partialTransfersChanged();
+}
+
 void FileStreamsManager::onProfileClosed(const QString &AName)
 {
 	Q_UNUSED(AName);
@@ -376,6 +517,9 @@ void FileStreamsManager::onProfileClosed(const QString &AName)
 
 	foreach(IFileStream *stream, FStreams.values())
 		delete stream->instance();
+
+	FPartialTransfers.clear();
+	emit partialTransfersChanged();
 }
 
 Q_EXPORT_PLUGIN2(plg_filestreamsmanager, FileStreamsManager);
@@ -50,14 +50,25 @@ public:
 	virtual QList<IFileStreamHandler *> streamHandlers() const;
 	virtual void insertStreamsHandler(int AOrder, IFileStreamHandler *AHandler);
 	virtual void removeStreamsHandler(int AOrder, IFileStreamHandler *AHandler);
+	// Partial Transfers
+	virtual QList<IPartialFileTransfer> partialTransfers() const;
+	virtual IPartialFileTransfer findPartialTransfer(const Jid &AContactJid, const QString &AFileName, qint64 AFileSize, const QString &AFileHash) const;
+	virtual void insertPartialTransfer(const IPartialFileTransfer &ATransfer);
+	virtual void removePartialTransfer(const QString &AFileName);
 signals:
 	void streamCreated(IFileStream *AStream);
 	void streamDestroyed(IFileStream *AStream);
 	void streamHandlerInserted(int AOrder, IFileStreamHandler *AHandler);
 	void streamHandlerRemoved(int AOrder, IFileStreamHandler *AHandler);
+	void partialTransfersChanged();
+protected:
+	QString partialTransfersFileName() const;
+	void loadPartialTransfers();
+	void savePartialTransfers() const;
 protected slots:
 	void onStreamDestroyed();
 	void onShowFileStreamsWindow(bool);
+	void onProfileOpened(const QString &AName);
 	void onProfileClosed(const QString &AName);
 private:
 	IDataStreamsManager *FDataManager;
@@ -68,6 +79,7 @@ private:
 	QMap<QString, IFileStream *> FStreams;
 	QMultiMap<int, IFileStreamHandler *> FHandlers;
 	QMap<QString, IFileStreamHandler *> FStreamHandler;
+	QMap<QString, IPartialFileTransfer> FPartialTransfers;
 private:
 	QPointer<FileStreamsWindow> FFileStreamsWindow;
 };
@@ -2,12 +2,14 @@ FORMS = filestreamswindow.ui \
         filestreamsoptionswidget.ui
 
 HEADERS = transferthread.h \
+          hashthread.h \
           filestream.h \
           filestreamswindow.h \
           filestreamsoptionswidget.h \
           filestreamsmanager.h 
 
 SOURCES = transferthread.cpp \
+          hashthread.cpp \
           filestream.cpp \
           filestreamswindow.cpp \
           filestreamsoptionswidget.cpp \
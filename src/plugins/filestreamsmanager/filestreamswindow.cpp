@@ -1,5 +1,6 @@
 #include "filestreamswindow.h"
 
+#include <QSet>
 #include <QTimer>
 #include <QVariant>
 #include <definitions/menuicons.h>
@@ -51,6 +52,7 @@ FileStreamsWindow::FileStreamsWindow(IFileStreamsManager *AManager, QWidget *APa
 
 	connect(FManager->instance(),SIGNAL(streamCreated(IFileStream *)),SLOT(onStreamCreated(IFileStream *)));
 	connect(FManager->instance(),SIGNAL(streamDestroyed(IFileStream *)),SLOT(onStreamDestroyed(IFileStream *)));
+	connect(FManager->instance(),SIGNAL(partialTransfersChanged()),SLOT(onPartialTransfersChanged()));
 
 	if (!restoreGeometry(Options::fileValue("filestreams.filestreamswindow.geometry").toByteArray()))
 		setGeometry(WidgetManager::alignGeometry(QSize(640,320),this));
@@ -75,6 +77,7 @@ void FileStreamsWindow::initialize()
 
 	foreach(IFileStream *stream, FManager->streams()) {
 		appendStream(stream); }
+	updatePartialTransfers();
 
 	FProxy.setSortRole(IDR_VALUE);
 	ui.tbvStreams->horizontalHeader()->setSortIndicator(CMN_FILENAME,Qt::AscendingOrder);
@@ -197,6 +200,51 @@ void FileStreamsWindow::removeStream(IFileStream *AStream)
 		qDeleteAll(FStreamsModel.takeRow(row));
 }
 
+void FileStreamsWindow::updatePartialTransfers()
+{
+	// Partial transfers are shown only while there is no stream for the same file
+	for (int row=FStreamsModel.rowCount()-1; row>=0; row--)
+		if (FStreamsModel.item(row,CMN_FILENAME)->data(IDR_STREAMID).toString().isEmpty())
+			qDeleteAll(FStreamsModel.takeRow(row));
+
+	QSet<QString> streamFiles;
+	foreach(IFileStream *stream, FManager->streams())
+		streamFiles += stream->fileName();
+
+	foreach(const IPartialFileTransfer &partial, FManager->partialTransfers())
+	{
+		if (!streamFiles.contains(partial.fileName))
+		{
+			QList<QStandardItem *> columns;
+			for (int column=0; column<CMN_COUNT; column++)
+			{
+				columns.append(new QStandardItem());
+				columns[column]->setTextAlignment(column!=CMN_FILENAME ? Qt::AlignCenter : Qt::AlignVCenter|Qt::AlignLeft);
+			}
+
+			QString fname = partial.fileName.split("/").last();
+			columns[CMN_FILENAME]->setText(fname);
+			columns[CMN_FILENAME]->setData(fname, IDR_VALUE);
+			columns[CMN_FILENAME]->setToolTip(partial.fileName);
+			columns[CMN_FILENAME]->setIcon(IconStorage::staticStorage(RSR_STORAGE_MENUICONS)->getIcon(MNI_FILETRANSFER_RECEIVE));
+
+			columns[CMN_STATE]->setText(tr("Resumable"));
+			columns[CMN_STATE]->setData(IFileStream::Aborted, IDR_VALUE);
+
+			columns[CMN_SIZE]->setText(sizeName(partial.fileSize));
+			columns[CMN_SIZE]->setData(partial.fileSize, IDR_VALUE);
+
+			qint64 percent = partial.fileSize>0 ? (partial.receivedSize*100)/partial.fileSize : 0;
+			columns[CMN_PROGRESS]->setText(QString::number(percent)+"%");
+			columns[CMN_PROGRESS]->setData(percent, IDR_VALUE);
+
+			columns[CMN_SPEED]->setData(0, IDR_VALUE);
+
+			FStreamsModel.appendRow(columns);
+		}
+	}
+}
+
 int FileStreamsWindow::streamRow(const QString &AStreamId) const
 {
 	for (int row=0; row<FStreamsModel.rowCount(); row++)
@@ -254,6 +302,7 @@ QString FileStreamsWindow::sizeName(qint64 ABytes) const
 void FileStreamsWindow::onStreamCreated(IFileStream *AStream)
 {
 	appendStream(AStream);
+	updatePartialTransfers();
 }
 
 void FileStreamsWindow::onStreamStateChanged()
@@ -287,6 +336,12 @@ void FileStreamsWindow::onStreamPropertiesChanged()
 void FileStreamsWindow::onStreamDestroyed(IFileStream *AStream)
 {
 	removeStream(AStream);
+	updatePartialTransfers();
+}
+
+void FileStreamsWindow::onPartialTransfersChanged()
+{
+	updatePartialTransfers();
 }
 
 void FileStreamsWindow::onTableIndexActivated(const QModelIndex &AIndex)
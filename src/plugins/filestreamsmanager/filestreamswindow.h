@@ -25,6 +25,7 @@ protected:
 	void updateStreamProgress(IFileStream *AStream);
 	void updateStreamProperties(IFileStream *AStream);
 	void removeStream(IFileStream *AStream);
+	void updatePartialTransfers();
 	int streamRow(const QString &AStreamId) const;
 	QList<QStandardItem *> streamColumns(const QString &AStreamId) const;
 	QString sizeName(qint64 ABytes) const;
@@ -35,6 +36,7 @@ protected slots:
 	void onStreamProgressChanged();
 	void onStreamPropertiesChanged();
 	void onStreamDestroyed(IFileStream *AStream);
+	void onPartialTransfersChanged();
 	void onTableIndexActivated(const QModelIndex &AIndex);
 	void onUpdateStatusBar();
 private:
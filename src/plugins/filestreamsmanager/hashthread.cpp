@@ -0,0 +1,56 @@
+#include "hashthread.h"
+
+#include <QFile>
+#include <QCryptographicHash>
+
+#define HASH_BUFFER_SIZE      51200
+
+HashThread::HashThread(const QString &AFileName, QObject *AParent) : QThread(AParent)
+{
+	FFileName = AFileName;
+	FAborted = false;
+}
+
+HashThread::~HashThread()
+{
+	abort();
+	wait();
+}
+
+void HashThread::abort()
+{
+	FAborted = true;
+}
+
+bool HashThread::isAborted() const
+{
+	return FAborted;
+}
+
+QString HashThread::fileName() const
+{
+	return FFileName;
+}
+
+QString HashThread::fileHash() const
+{
+	return FFileHash;
+}
+
+void HashThread::run()
+{
+	char buffer[HASH_BUFFER_SIZE];
+	QCryptographicHash hash(QCryptographicHash::Md5);
+
+	QFile file(FFileName);
+	if (file.open(QIODevice::ReadOnly))
+	{
+		qint64 readedBytes = 0;
+		while (!FAborted && (readedBytes = file.read(buffer,HASH_BUFFER_SIZE))>0)
+			hash.addData(buffer,readedBytes);
+
+		if (!FAborted && readedBytes==0 && file.atEnd())
+			FFileHash = hash.result().toHex();
+		file.close();
+	}
+}
@@ -0,0 +1,26 @@
+#ifndef HASHTHREAD_H
+#define HASHTHREAD_H
+
+#include <QThread>
+
+class HashThread :
+	public QThread
+{
+	Q_OBJECT;
+public:
+	HashThread(const QString &AFileName, QObject *AParent);
+	~HashThread();
+	void abort();
+	bool isAborted() const;
+	QString fileName() const;
+	QString fileHash() const;
+protected:
+	void run();
+private:
+	QString FFileName;
+	QString FFileHash;
+private:
+	volatile bool FAborted;
+};
+
+#endif // HASHTHREAD_H
@@ -1,15 +1,22 @@
 #include "transferthread.h"
 
 #include <QByteArray>
+#include <QMutexLocker>
 
 #define TRANSFER_BUFFER_SIZE      51200
 
-TransferThread::TransferThread(IDataStreamSocket *ASocket, QFile *AFile, int AKind, qint64 ABytes, QObject *AParent) : QThread(AParent)
+TransferThread::TransferThread(IDataStreamSocket *ASocket, QFile *AFile, int AKind, qint64 ABytes, bool ACalcHash, QObject *AParent) : QThread(AParent), FHash(QCryptographicHash::Md5)
 {
 	FKind = AKind;
 	FFile = AFile;
 	FSocket = ASocket;
 	FBytesToTransfer = ABytes;
+	FCalcHash = ACalcHash;
+
+	FPrefixValid = true;
+	FPrefixBytes = 0;
+	FPartialSize = 0;
+	FHashActive = false;
 
 	FAborted = false;
 }
@@ -30,6 +37,42 @@ bool TransferThread::isAborted() const
 	return FAborted;
 }
 
+QString TransferThread::fileHash() const
+{
+	return FFileHash;
+}
+
+bool TransferThread::isPrefixValid() const
+{
+	return FPrefixValid;
+}
+
+qint64 TransferThread::partialSize() const
+{
+	QMutexLocker locker(&FHashLock);
+	return FPartialSize;
+}
+
+QString TransferThread::partialHash() const
+{
+	// Hash of data transferred so far is available while thread is running
+	QMutexLocker locker(&FHashLock);
+	return FHashActive ? QString(FHash.result().toHex()) : FPartialHash;
+}
+
+void TransferThread::setHashPrefix(qint64 ABytes, const QString &AHash)
+{
+	if (!isRunning())
+	{
+		FPrefixBytes = ABytes;
+		FPrefixHash = AHash.toLower();
+
+		// Until prefix is rehashed the known state is the expected one
+		FPartialSize = !FPrefixHash.isEmpty() ? FPrefixBytes : 0;
+		FPartialHash = FPrefixHash;
+	}
+}
+
 void TransferThread::run()
 {
 	qint64 transferedBytes = 0;
@@ -38,6 +81,14 @@ void TransferThread::run()
 	QIODevice *inDevice = FKind==IFileStream::SendFile ? FFile : FSocket->instance();
 	QIODevice *outDevice = FKind==IFileStream::SendFile ? FSocket->instance() : FFile;
 
+	bool hashReady = !FCalcHash || FPrefixBytes<=0 || hashFilePrefix(buffer,TRANSFER_BUFFER_SIZE);
+	if (!hashReady)
+		abort();
+
+	FHashLock.lock();
+	FHashActive = FCalcHash && hashReady;
+	FHashLock.unlock();
+
 	while (!FAborted && transferedBytes<FBytesToTransfer)
 	{
 		qint64 readedBytes = inDevice->read(buffer,qMin(qint64(TRANSFER_BUFFER_SIZE),FBytesToTransfer-transferedBytes));
@@ -62,6 +113,18 @@ void TransferThread::run()
 					abort();
 				}
 			}
+
+			// Hash is calculated on the fly to avoid reading the file twice
+			if (FCalcHash && writtenBytes==readedBytes)
+			{
+				// Hashed data should be in the file if process crashes before next journal update
+				if (FKind == IFileStream::ReceiveFile)
+					FFile->flush();
+
+				QMutexLocker locker(&FHashLock);
+				FHash.addData(buffer,readedBytes);
+				FPartialSize += readedBytes;
+			}
 		}
 		else if (readedBytes == 0)
 		{
@@ -76,5 +139,53 @@ void TransferThread::run()
 	while (FKind==IFileStream::SendFile && !FAborted && FSocket->flush())
 		outDevice->waitForBytesWritten(100);
 
+	if (FCalcHash && hashReady)
+	{
+		QMutexLocker locker(&FHashLock);
+		FHashActive = false;
+
+		// Stream may be aborted on socket close right after the last block was written
+		FPartialHash = FHash.result().toHex();
+		if (transferedBytes == FBytesToTransfer)
+			FFileHash = FPartialHash;
+	}
+
 	FFile->close();
 }
+
+bool TransferThread::hashFilePrefix(char *ABuffer, qint64 ABufSize)
+{
+	// Data received before transfer was interrupted is hashed to verify it and to continue file hash
+	qint64 hashedBytes = 0;
+	QCryptographicHash prefixHash(QCryptographicHash::Md5);
+
+	QFile file(FFile->fileName());
+	if (file.open(QIODevice::ReadOnly))
+	{
+		while (!FAborted && hashedBytes<FPrefixBytes)
+		{
+			qint64 readedBytes = file.read(ABuffer,qMin(ABufSize,FPrefixBytes-hashedBytes));
+			if (readedBytes <= 0)
+				break;
+			FHash.addData(ABuffer,readedBytes);
+			prefixHash.addData(ABuffer,readedBytes);
+			hashedBytes += readedBytes;
+		}
+		file.close();
+	}
+
+	if (FAborted && hashedBytes<FPrefixBytes)
+		return false;
+
+	QMutexLocker locker(&FHashLock);
+	if (hashedBytes==FPrefixBytes && (FPrefixHash.isEmpty() || FPrefixHash==prefixHash.result().toHex()))
+	{
+		FPartialSize = hashedBytes;
+		return true;
+	}
+
+	FPrefixValid = false;
+	FPartialSize = 0;
+	FPartialHash.clear();
+	return false;
+}
@@ -2,7 +2,9 @@
 #define TRANSFERTHREAD_H
 
 #include <QFile>
+#include <QMutex>
 #include <QThread>
+#include <QCryptographicHash>
 #include <interfaces/ifilestreamsmanager.h>
 #include <interfaces/idatastreamsmanager.h>
 
@@ -11,19 +13,36 @@ class TransferThread :
 {
 	Q_OBJECT;
 public:
-	TransferThread(IDataStreamSocket *ASocket, QFile *AFile, int AKind, qint64 ABytes, QObject *AParent);
+	TransferThread(IDataStreamSocket *ASocket, QFile *AFile, int AKind, qint64 ABytes, bool ACalcHash, QObject *AParent);
 	~TransferThread();
 	void abort();
 	bool isAborted() const;
+	QString fileHash() const;
+	bool isPrefixValid() const;
+	qint64 partialSize() const;
+	QString partialHash() const;
+	void setHashPrefix(qint64 ABytes, const QString &AHash);
 signals:
 	void transferProgress(qint64 ABytes);
 protected:
 	void run();
+	bool hashFilePrefix(char *ABuffer, qint64 ABufSize);
 private:
 	int FKind;
 	QFile *FFile;
 	qint64 FBytesToTransfer;
 	IDataStreamSocket *FSocket;
+private:
+	bool FCalcHash;
+	bool FPrefixValid;
+	qint64 FPrefixBytes;
+	QString FPrefixHash;
+	qint64 FPartialSize;
+	QString FPartialHash;
+	QString FFileHash;
+	bool FHashActive;
+	QCryptographicHash FHash;
+	mutable QMutex FHashLock;
 private:
 	volatile bool FAborted;
 };
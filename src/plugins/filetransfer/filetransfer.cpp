@@ -102,6 +102,10 @@ bool FileTransfer::initConnections(IPluginManager *APluginManager, int &AInitOrd
 		FDataPublisher = qobject_cast<IDataStreamsPublisher *>(plugin->instance());
 		if (FDataPublisher)
 		{
+			connect(FDataPublisher->instance(),SIGNAL(streamPublished(const IPublicDataStream &)),
+				SLOT(onPublicStreamPublished(const IPublicDataStream &)));
+			connect(FDataPublisher->instance(),SIGNAL(streamRemoved(const IPublicDataStream &)),
+				SLOT(onPublicStreamRemoved(const IPublicDataStream &)));
 			connect(FDataPublisher->instance(),SIGNAL(streamStartAccepted(const QString &, const QString &)),
 				SLOT(onPublicStreamStartAccepted(const QString &, const QString &)));
 			connect(FDataPublisher->instance(),SIGNAL(streamStartRejected(const QString &, const XmppError &)),
@@ -651,6 +655,16 @@ bool FileTransfer::fileStreamProcessRequest(int AOrder, const QString &AStreamId
 				stream->setRangeSupported(!fileElem.firstChildElement("range").isNull());
 				stream->setAcceptableMethods(methods);
 
+				if (stream->isRangeSupported())
+				{
+					IPartialFileTransfer partial = FFileManager->findPartialTransfer(stream->contactJid(),stream->fileName(),stream->fileSize(),stream->fileHash());
+					if (!partial.isNull())
+					{
+						LOG_STRM_INFO(ARequest.to(),QString("Found partially received file for transfer request, sid=%1, received=%2").arg(AStreamId).arg(partial.receivedSize));
+						stream->setRangeOffset(partial.receivedSize);
+					}
+				}
+
 				StreamDialog *dialog = getStreamDialog(stream);
 				dialog->setSelectableMethods(methods);
 
@@ -1026,7 +1040,7 @@ bool FileTransfer::autoStartStream(IFileStream *AStream) const
 {
 	if (Options::node(OPV_FILETRANSFER_AUTORECEIVE).value().toBool() && AStream->streamKind()==IFileStream::ReceiveFile)
 	{
-		if (!QFile::exists(AStream->fileName()))
+		if (AStream->rangeOffset()>0 || !QFile::exists(AStream->fileName()))
 		{
 			IRoster *roster = FRosterManager!=NULL ? FRosterManager->findRoster(AStream->streamJid()) : NULL;
 			IRosterItem ritem = roster!=NULL ? roster->findItem(AStream->contactJid()) : IRosterItem();
@@ -1333,6 +1347,21 @@ void FileTransfer::onPublishFilesByAction(bool)
 	}
 }
 
+void FileTransfer::onPublicStreamPublished(const IPublicDataStream &AStream)
+{
+	// Public files in messages are shown differently when published by this client
+	Q_UNUSED(AStream);
+	if (FMessageProcessor)
+		FMessageProcessor->clearMessageTextCache();
+}
+
+void FileTransfer::onPublicStreamRemoved(const IPublicDataStream &AStream)
+{
+	Q_UNUSED(AStream);
+	if (FMessageProcessor)
+		FMessageProcessor->clearMessageTextCache();
+}
+
 void FileTransfer::onPublicStreamStartAccepted(const QString &ARequestId, const QString &ASessionId)
 {
 	if (FPublicReceiveRequests.contains(ARequestId))
@@ -116,6 +116,8 @@ protected slots:
 	void onSendFileByAction(bool);
 	void onPublishFilesByAction(bool);
 protected slots:
+	void onPublicStreamPublished(const IPublicDataStream &AStream);
+	void onPublicStreamRemoved(const IPublicDataStream &AStream);
 	void onPublicStreamStartAccepted(const QString &ARequestId, const QString &ASessionId);
 	void onPublicStreamStartRejected(const QString &ARequestId, const XmppError &AError);
 protected slots:
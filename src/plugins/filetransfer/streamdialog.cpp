@@ -148,6 +148,7 @@ bool StreamDialog::acceptFileName(const QString &AFile)
 					QMessageBox::warning(this,tr("Warning"),tr("Can not delete existing file"));
 					return false;
 				}
+				FFileStream->setRangeOffset(0);
 			}
 			else
 			{
@@ -166,6 +167,7 @@ bool StreamDialog::acceptFileName(const QString &AFile)
 					QMessageBox::warning(this,tr("Warning"),tr("Can not delete existing file"));
 					return false;
 				}
+				FFileStream->setRangeOffset(0);
 			}
 			else
 			{
@@ -173,6 +175,11 @@ bool StreamDialog::acceptFileName(const QString &AFile)
 			}
 		}
 	}
+	else if (!fileInfo.exists() && FFileStream->streamKind()==IFileStream::ReceiveFile)
+	{
+		// Offset of partially received file is not applicable to a new file
+		FFileStream->setRangeOffset(0);
+	}
 	else if (!fileInfo.exists() && FFileStream->streamKind()==IFileStream::SendFile)
 	{
 		QMessageBox::warning(this,tr("Warning"),tr("Selected file does not exists"));
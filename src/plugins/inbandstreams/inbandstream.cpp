@@ -16,6 +16,7 @@
 #define MAX_BUFFER_SIZE           8192
 
 #define DATA_TIMEOUT              60000
+#define MAX_OUTSTANDING_PAKETS    4
 #define OPEN_TIMEOUT              30000
 #define CLOSE_TIMEOUT             10000
 
@@ -63,6 +64,9 @@ InBandStream::InBandStream(IStanzaProcessor *AProcessor, const QString &AStreamI
 	FMaxBlockSize = DEFAULT_MAX_BLOCK_SIZE;
 	FStanzaType = DEFAULT_DATA_STANZA_TYPE;
 	FStreamState = IDataStreamSocket::Closed;
+	FFlushPending = false;
+	FAcksDelayed = false;
+	FReadBufferLimit = MAX_BUFFER_SIZE;
 
 	LOG_STRM_INFO(AStreamJid,QString("In-band stream created, sid=%1, kind=%2").arg(FStreamId).arg(FStreamKind));
 }
@@ -84,16 +88,22 @@ bool InBandStream::stanzaReadWrite(int AHandleId, const Jid &AStreamJid, Stanza
 			QByteArray data =  QByteArray::fromBase64(elem.text().toLatin1());
 			if (FSeqIn==elem.attribute("seq").toInt() && data.size()>0 && data.size()<=FBlockSize)
 			{
+				FThreadLock.lockForWrite();
+				FReadBuffer.write(data);
+				bool bufferFull = FReadBuffer.size()>FReadBufferLimit;
+				FAcksDelayed = FAcksDelayed || (bufferFull && AStanza.kind()==STANZA_KIND_IQ);
+				FThreadLock.unlock();
+
 				if (AStanza.kind() == STANZA_KIND_IQ)
 				{
+					// Data is not acknowledged while read buffer is full, so contact stops sending
 					Stanza result = FStanzaProcessor->makeReplyResult(AStanza);
-					FStanzaProcessor->sendStanzaOut(AStreamJid,result);
+					if (bufferFull || !FPendingAcks.isEmpty())
+						FPendingAcks.append(result);
+					else
+						FStanzaProcessor->sendStanzaOut(AStreamJid,result);
 				}
 
-				FThreadLock.lockForWrite();
-				FReadBuffer.write(data);
-				FThreadLock.unlock();
-
 				FSeqIn = FSeqIn<USHRT_MAX ? FSeqIn+1 : 0;
 				emit readyRead();
 				FReadyReadCondition.wakeAll();
@@ -163,15 +173,16 @@ bool InBandStream::stanzaReadWrite(int AHandleId, const Jid &AStreamJid, Stanza
 void InBandStream::stanzaRequestResult(const Jid &AStreamJid, const Stanza &AStanza)
 {
 	Q_UNUSED(AStreamJid);
-	if (AStanza.id() == FDataIqRequestId)
+	if (FDataIqRequests.contains(AStanza.id()))
 	{
+		quint16 seq = FDataIqRequests.take(AStanza.id());
 		if (AStanza.isResult())
 		{
-			FDataIqRequestId.clear();
 			sendNextPaket();
 		}
 		else
 		{
+			LOG_STRM_WARNING(FStreamJid,QString("Data paket not accepted, sid=%1, seq=%2").arg(FStreamId).arg(seq));
 			abort(XmppStanzaError(AStanza));
 		}
 	}
@@ -287,16 +298,8 @@ bool InBandStream::open(QIODevice::OpenMode AMode)
 		setStreamError(XmppError::null);
 		if (streamKind() == IDataStream::Initiator)
 		{
-			Stanza openRequest(STANZA_KIND_IQ);
-			openRequest.setType(STANZA_TYPE_SET).setTo(FContactJid.full()).setUniqueId();
-			QDomElement elem = openRequest.addElement("open",NS_INBAND_BYTESTREAMS);
-			elem.setAttribute("sid",FStreamId);
-			elem.setAttribute("block-size",FBlockSize);
-			elem.setAttribute("stanza",FStanzaType==StanzaMessage ? STANZA_KIND_MESSAGE : STANZA_KIND_IQ);
-			if (FStanzaProcessor->sendStanzaRequest(this,FStreamJid,openRequest,OPEN_TIMEOUT))
+			if (sendOpenRequest())
 			{
-				LOG_STRM_INFO(FStreamJid,QString("Open stream request sent, sid=%1").arg(FStreamId));
-				FOpenRequestId = openRequest.id();
 				setOpenMode(AMode);
 				setStreamState(IDataStreamSocket::Opening);
 				return true;
@@ -422,7 +425,14 @@ void InBandStream::setDataStanzaType(int AType)
 qint64 InBandStream::readData(char *AData, qint64 AMaxSize)
 {
 	QWriteLocker locker(&FThreadLock);
-	return FReadBuffer.read(AData,AMaxSize);
+	qint64 bytes = FReadBuffer.read(AData,AMaxSize);
+	if (FAcksDelayed && FReadBuffer.size()<=FReadBufferLimit)
+	{
+		FAcksDelayed = false;
+		DataEvent *dataEvent = new DataEvent(false);
+		QCoreApplication::postEvent(this,dataEvent);
+	}
+	return bytes;
 }
 
 qint64 InBandStream::writeData(const char *AData, qint64 AMaxSize)
@@ -444,21 +454,41 @@ bool InBandStream::event(QEvent *AEvent)
 	if (AEvent->type() == DataEvent::registeredType())
 	{
 		DataEvent *dataEvent = static_cast<DataEvent *>(AEvent);
+		sendPendingAcks();
 		sendNextPaket(dataEvent->isFlush());
 		return true;
 	}
 	return QIODevice::event(AEvent);
 }
 
+bool InBandStream::sendOpenRequest()
+{
+	Stanza openRequest(STANZA_KIND_IQ);
+	openRequest.setType(STANZA_TYPE_SET).setTo(FContactJid.full()).setUniqueId();
+	QDomElement elem = openRequest.addElement("open",NS_INBAND_BYTESTREAMS);
+	elem.setAttribute("sid",FStreamId);
+	elem.setAttribute("block-size",FBlockSize);
+	elem.setAttribute("stanza",FStanzaType==StanzaMessage ? STANZA_KIND_MESSAGE : STANZA_KIND_IQ);
+	if (FStanzaProcessor->sendStanzaRequest(this,FStreamJid,openRequest,OPEN_TIMEOUT))
+	{
+		LOG_STRM_INFO(FStreamJid,QString("Open stream request sent, sid=%1, block-size=%2").arg(FStreamId).arg(FBlockSize));
+		FOpenRequestId = openRequest.id();
+		return true;
+	}
+	return false;
+}
+
 bool InBandStream::sendNextPaket(bool AFlush)
 {
 	bool sent = false;
-	if (isOpen() && FDataIqRequestId.isEmpty() && (bytesToWrite()>=FBlockSize || AFlush))
+	FFlushPending = FFlushPending || AFlush;
+	while (isOpen() && FDataIqRequests.count()<MAX_OUTSTANDING_PAKETS && (bytesToWrite()>=FBlockSize || (FFlushPending && bytesToWrite()>0)))
 	{
 		FThreadLock.lockForWrite();
 		QByteArray data = FWriteBuffer.read(FBlockSize);
 		FThreadLock.unlock();
 
+		sent = false;
 		if (!data.isEmpty())
 		{
 			if (FStanzaProcessor)
@@ -469,7 +499,7 @@ bool InBandStream::sendNextPaket(bool AFlush)
 				QDomElement dataElem = paket.addElement("data",NS_INBAND_BYTESTREAMS);
 				dataElem.setAttribute("sid",FStreamId);
 				dataElem.setAttribute("seq",FSeqOut);
-				dataElem.appendChild(paket.createTextNode(QString::fromUtf8(data.toBase64())));
+				dataElem.appendChild(paket.createTextNode(QString::fromLatin1(data.toBase64())));
 
 				if (FStanzaType == StanzaMessage)
 				{
@@ -483,7 +513,7 @@ bool InBandStream::sendNextPaket(bool AFlush)
 					ruleElem.setAttribute("value","exact");
 					ruleElem.setAttribute("action","error");
 
-					DataEvent *dataEvent = new DataEvent(AFlush);
+					DataEvent *dataEvent = new DataEvent(FFlushPending);
 					QCoreApplication::postEvent(this, dataEvent);
 
 					sent = FStanzaProcessor->sendStanzaOut(FStreamJid,paket);
@@ -491,8 +521,9 @@ bool InBandStream::sendNextPaket(bool AFlush)
 				else
 				{
 					paket.setType(STANZA_TYPE_SET);
-					FDataIqRequestId = paket.id();
 					sent = FStanzaProcessor->sendStanzaRequest(this,FStreamJid,paket,DATA_TIMEOUT);
+					if (sent)
+						FDataIqRequests.insert(paket.id(),FSeqOut);
 				}
 			}
 
@@ -507,10 +538,32 @@ bool InBandStream::sendNextPaket(bool AFlush)
 				abort(XmppError(IERR_INBAND_STREAM_DATA_NOT_SENT));
 			}
 		}
+
+		// Next message paket will be sent from posted data event
+		if (FStanzaType == StanzaMessage)
+			break;
 	}
+
+	if (bytesToWrite() == 0)
+		FFlushPending = false;
+
 	return sent;
 }
 
+void InBandStream::sendPendingAcks()
+{
+	if (!FPendingAcks.isEmpty())
+	{
+		FThreadLock.lockForWrite();
+		bool bufferFull = FReadBuffer.size()>FReadBufferLimit;
+		FAcksDelayed = bufferFull;
+		FThreadLock.unlock();
+
+		while (!bufferFull && !FPendingAcks.isEmpty())
+			FStanzaProcessor->sendStanzaOut(FStreamJid,FPendingAcks.takeFirst());
+	}
+}
+
 void InBandStream::setStreamState(int AState)
 {
 	if (streamState() != AState)
@@ -519,8 +572,13 @@ void InBandStream::setStreamState(int AState)
 		{
 			FSeqIn = 0;
 			FSeqOut = 0;
-			FDataIqRequestId.clear();
+			FFlushPending = false;
+			FDataIqRequests.clear();
+			FPendingAcks.clear();
 			FThreadLock.lockForWrite();
+			FAcksDelayed = false;
+			FReadBufferLimit = qMax(FBlockSize*MAX_OUTSTANDING_PAKETS,MAX_BUFFER_SIZE);
+			FWriteBuffer.setMaximumSize(FReadBufferLimit);
 			QIODevice::open(openMode());
 			FThreadLock.unlock();
 			LOG_STRM_INFO(FStreamJid,QString("In-band stream opened, sid=%1, stanzaType=%2").arg(FStreamId).arg(FStanzaType));
@@ -530,6 +588,7 @@ void InBandStream::setStreamState(int AState)
 			removeStanzaHandle(FSHIOpen);
 			removeStanzaHandle(FSHIClose);
 			removeStanzaHandle(FSHIData);
+			FPendingAcks.clear();
 			emit readChannelFinished();
 
 			FThreadLock.lockForWrite();
@@ -65,7 +65,9 @@ protected:
 	void setOpenMode(OpenMode AMode);
 	virtual bool event(QEvent *AEvent);
 protected:
+	bool sendOpenRequest();
 	bool sendNextPaket(bool AFlush = false);
+	void sendPendingAcks();
 	void setStreamState(int AState);
 	void setStreamError(const XmppError &AError);
 	int insertStanzaHandle(const QString &ACondition);
@@ -85,13 +87,17 @@ private:
 	int FSHIData;
 	QString FOpenRequestId;
 	QString FCloseRequestId;
-	QString FDataIqRequestId;
+	QMap<QString,quint16> FDataIqRequests;
+	QList<Stanza> FPendingAcks;
 private:
 	int FBlockSize;
 	int FMaxBlockSize;
 	int FStanzaType;
 	quint16 FSeqIn;
 	quint16 FSeqOut;
+	bool FFlushPending;
+	bool FAcksDelayed;
+	qint64 FReadBufferLimit;
 private:
 	RingBuffer FReadBuffer;
 	RingBuffer FWriteBuffer;
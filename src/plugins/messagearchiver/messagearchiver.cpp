@@ -1142,12 +1142,12 @@ QString MessageArchiver::loadHeaders(const Jid &AStreamJid, const IArchiveReques
 	return QString::null;
 }
 
-QString MessageArchiver::loadCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader)
+QString MessageArchiver::loadCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader, int ALastMessages)
 {
 	IArchiveEngine *engine = findArchiveEngine(AHeader.engineId);
 	if (engine)
 	{
-		QString id = engine->loadCollection(AStreamJid,AHeader);
+		QString id = engine->loadCollection(AStreamJid,AHeader,ALastMessages);
 		if (!id.isEmpty())
 		{
 			CollectionRequest request;
@@ -1845,7 +1845,12 @@ void MessageArchiver::processMessagesRequest(const QString &ALocalId, MessagesRe
 	}
 	else
 	{
-		QString id = loadCollection(ARequest.streamJid,ARequest.headers.takeFirst());
+		// Caller does not need messages and notes beyond maxItems, so only the tail of collection is required
+		int lastMessages = -1;
+		if (ARequest.request.tailOnly && ARequest.request.order==Qt::DescendingOrder && ARequest.request.maxItems<(quint32)INT_MAX)
+			lastMessages = ARequest.request.maxItems - ARequest.body.messages.count() + 1;
+
+		QString id = loadCollection(ARequest.streamJid,ARequest.headers.takeFirst(),lastMessages);
 		if (!id.isEmpty())
 		{
 			FRequestId2LocalId.insert(id,ALocalId);
@@ -116,7 +116,7 @@ public:
 	//Archive Management
 	virtual QString loadMessages(const Jid &AStreamJid, const IArchiveRequest &ARequest);
 	virtual QString loadHeaders(const Jid &AStreamJid, const IArchiveRequest &ARequest);
-	virtual QString loadCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader);
+	virtual QString loadCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader, int ALastMessages = -1);
 	virtual QString removeCollections(const Jid &AStreamJid, const IArchiveRequest &ARequest);
 	//Utilities
 	virtual void elementToCollection(const Jid &AStreamJid, const QDomElement &AChatElem, IArchiveCollection &ACollection) const;
@@ -1,22 +1,36 @@
 #include "messageprocessor.h"
 
+#include <QUrl>
+#include <QImage>
 #include <QVariant>
+#include <QTextBlock>
 #include <QTextCursor>
+#include <QElapsedTimer>
+#include <QCryptographicHash>
 #include <definitions/namespaces.h>
 #include <definitions/messagedataroles.h>
 #include <definitions/messagewriterorders.h>
 #include <definitions/notificationdataroles.h>
 #include <definitions/stanzahandlerorders.h>
+#include <definitions/optionvalues.h>
 #include <utils/logger.h>
 
 #define SHC_MESSAGE         "/message"
 
+#define TEXT_CACHE_MAX_COST (8*1024*1024)
+
 MessageProcessor::MessageProcessor()
 {
+	FPluginManager = NULL;
 	FDiscovery = NULL;
 	FNotifications = NULL;
 	FStanzaProcessor = NULL;
 	FXmppStreamManager = NULL;
+
+	FTextCacheHits = 0;
+	FTextCacheMisses = 0;
+	FTextRenderTime = 0;
+	FTextCache.setMaxCost(TEXT_CACHE_MAX_COST);
 }
 
 MessageProcessor::~MessageProcessor()
@@ -38,6 +52,9 @@ void MessageProcessor::pluginInfo(IPluginInfo *APluginInfo)
 bool MessageProcessor::initConnections(IPluginManager *APluginManager, int &AInitOrder)
 {
 	Q_UNUSED(AInitOrder);
+	FPluginManager = APluginManager;
+	connect(FPluginManager->instance(),SIGNAL(aboutToQuit()),SLOT(onApplicationAboutToQuit()));
+
 	IPlugin *plugin = APluginManager->pluginInterface("IXmppStreamManager").value(0,NULL);
 	if (plugin)
 	{
@@ -80,6 +97,10 @@ bool MessageProcessor::initObjects()
 	insertMessageWriter(MWO_MESSAGEPROCESSOR,this);
 	insertMessageWriter(MWO_MESSAGEPROCESSOR_ANCHORS,this);
 
+	connect(Options::instance(),SIGNAL(optionsOpened()),SLOT(onOptionsOpened()));
+	connect(Options::instance(),SIGNAL(optionsClosed()),SLOT(onOptionsClosed()));
+	connect(Options::instance(),SIGNAL(optionsChanged(const OptionsNode &)),SLOT(onOptionsChanged(const OptionsNode &)));
+
 	if (FDiscovery)
 	{
 		IDiscoFeature dfeature;
@@ -340,6 +361,21 @@ bool MessageProcessor::messageHasText(const Message &AMessage, const QString &AL
 
 bool MessageProcessor::messageToText(const Message &AMessage, QTextDocument *ADocument, const QString &ALang) const
 {
+	// Only conversion to an empty document can be taken from cache
+	QByteArray cacheKey = ADocument->isEmpty() ? messageTextCacheKey(AMessage,ALang) : QByteArray();
+	MessageTextCacheItem *item = !cacheKey.isEmpty() ? FTextCache.object(cacheKey) : NULL;
+	if (item != NULL)
+	{
+		FTextCacheHits++;
+		for (QMap<QString, QVariant>::const_iterator it=item->images.constBegin(); it!=item->images.constEnd(); ++it)
+			ADocument->addResource(QTextDocument::ImageResource,QUrl(it.key()),it.value());
+		QTextCursor(ADocument).insertFragment(item->fragment);
+		return item->changed;
+	}
+
+	QElapsedTimer renderTimer;
+	renderTimer.start();
+
 	bool changed = false;
 
 	Message messageCopy = AMessage;
@@ -347,6 +383,39 @@ bool MessageProcessor::messageToText(const Message &AMessage, QTextDocument *ADo
 	while (it.hasNext())
 		changed = it.next().value()->writeMessageToText(it.key(),messageCopy,ADocument,ALang) || changed;
 
+	FTextRenderTime += renderTimer.nsecsElapsed()/1000;
+
+	if (!cacheKey.isEmpty())
+	{
+		FTextCacheMisses++;
+
+		item = new MessageTextCacheItem;
+		item->changed = changed;
+		item->fragment = QTextDocumentFragment(ADocument);
+
+		// Images inserted by writers are stored in document resources, not in fragment
+		int cost = ADocument->characterCount()*sizeof(QChar);
+		for (QTextBlock block = ADocument->begin(); block.isValid(); block = block.next())
+		{
+			for (QTextBlock::iterator fit = block.begin(); !fit.atEnd(); ++fit)
+			{
+				QTextCharFormat format = fit.fragment().charFormat();
+				if (format.isImageFormat())
+				{
+					QString name = format.toImageFormat().name();
+					QVariant image = ADocument->resource(QTextDocument::ImageResource,QUrl(name));
+					if (image.isValid() && !item->images.contains(name))
+					{
+						item->images.insert(name,image);
+						cost += qvariant_cast<QImage>(image).byteCount();
+					}
+				}
+			}
+		}
+
+		FTextCache.insert(cacheKey,item,cost);
+	}
+
 	return changed;
 }
 
@@ -363,6 +432,11 @@ bool MessageProcessor::textToMessage(const QTextDocument *ADocument, Message &AM
 	return changed;
 }
 
+void MessageProcessor::clearMessageTextCache()
+{
+	FTextCache.clear();
+}
+
 IMessageWindow *MessageProcessor::getMessageWindow(const Jid &AStreamJid, const Jid &AContactJid, Message::MessageType AType, int AAction) const
 {
 	for (QMultiMap<int, IMessageHandler *>::const_iterator it = FMessageHandlers.constBegin(); it!=FMessageHandlers.constEnd(); ++it)
@@ -407,13 +481,19 @@ QMultiMap<int, IMessageWriter *> MessageProcessor::messageWriters() const
 void MessageProcessor::insertMessageWriter(int AOrder, IMessageWriter *AWriter)
 {
 	if (AWriter && !FMessageWriters.contains(AOrder,AWriter))
+	{
 		FMessageWriters.insertMulti(AOrder,AWriter);
+		clearMessageTextCache();
+	}
 }
 
 void MessageProcessor::removeMessageWriter(int AOrder, IMessageWriter *AWriter)
 {
 	if (FMessageWriters.contains(AOrder,AWriter))
+	{
 		FMessageWriters.remove(AOrder,AWriter);
+		clearMessageTextCache();
+	}
 }
 
 QMultiMap<int, IMessageEditor *> MessageProcessor::messageEditors() const
@@ -439,6 +519,14 @@ int MessageProcessor::newMessageId()
 	return messageId++;
 }
 
+QByteArray MessageProcessor::messageTextCacheKey(const Message &AMessage, const QString &ALang) const
+{
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	hash.addData(ALang.toUtf8());
+	hash.addData(AMessage.stanza().toByteArray());
+	return hash.result();
+}
+
 IMessageHandler *MessageProcessor::findMessageHandler(const Message &AMessage, int ADirection)
 {
 	for (QMultiMap<int, IMessageHandler *>::const_iterator it = FMessageHandlers.constBegin(); it!=FMessageHandlers.constEnd(); ++it)
@@ -510,4 +598,26 @@ void MessageProcessor::onXmppStreamJidChanged(IXmppStream *AXmppStream, const Ji
 	}
 }
 
+void MessageProcessor::onOptionsOpened()
+{
+	clearMessageTextCache();
+}
+
+void MessageProcessor::onOptionsClosed()
+{
+	clearMessageTextCache();
+}
+
+void MessageProcessor::onOptionsChanged(const OptionsNode &ANode)
+{
+	// Message writers may depend on message options, e.g. emoticons iconset
+	if (Options::node(OPV_MESSAGES_ROOT).isChildNode(ANode))
+		clearMessageTextCache();
+}
+
+void MessageProcessor::onApplicationAboutToQuit()
+{
+	LOG_INFO(QString("Message text cache statistics: size=%1, hits=%2, misses=%3, render-time=%4ms").arg(FTextCache.count()).arg(FTextCacheHits).arg(FTextCacheMisses).arg(FTextRenderTime/1000));
+}
+
 Q_EXPORT_PLUGIN2(plg_messageprocessor, MessageProcessor)
@@ -1,12 +1,22 @@
 #ifndef MESSAGEPROCESSOR_H
 #define MESSAGEPROCESSOR_H
 
+#include <QCache>
+#include <QTextDocumentFragment>
 #include <interfaces/ipluginmanager.h>
 #include <interfaces/imessageprocessor.h>
 #include <interfaces/ixmppstreammanager.h>
 #include <interfaces/istanzaprocessor.h>
 #include <interfaces/iservicediscovery.h>
 #include <interfaces/inotifications.h>
+#include <utils/options.h>
+
+struct MessageTextCacheItem
+{
+	bool changed;
+	QTextDocumentFragment fragment;
+	QMap<QString, QVariant> images;
+};
 
 class MessageProcessor :
 	public QObject,
@@ -54,6 +64,7 @@ public:
 	virtual bool messageHasText(const Message &AMessage, const QString &ALang=QString::null) const;
 	virtual bool messageToText(const Message &AMessage, QTextDocument *ADocument, const QString &ALang=QString::null) const;
 	virtual bool textToMessage(const QTextDocument *ADocument, Message &AMessage, const QString &ALang=QString::null) const;
+	virtual void clearMessageTextCache();
 	// Message Windows
 	virtual IMessageWindow *getMessageWindow(const Jid &AStreamJid, const Jid &AContactJid, Message::MessageType AType, int AAction) const;
 	// Message Handlers
@@ -79,12 +90,18 @@ protected:
 	void notifyMessage(IMessageHandler *AHandler, const Message &AMessage, int ADirection);
 	QString convertTextToBody(const QString &AString) const;
 	QString convertBodyToHtml(const QString &AString) const;
+	QByteArray messageTextCacheKey(const Message &AMessage, const QString &ALang) const;
 protected slots:
 	void onNotificationActivated(int ANotifyId);
 	void onNotificationRemoved(int ANotifyId);
 	void onXmppStreamActiveChanged(IXmppStream *AXmppStream, bool AActive);
 	void onXmppStreamJidChanged(IXmppStream *AXmppStream, const Jid &ABefore);
+	void onOptionsOpened();
+	void onOptionsClosed();
+	void onOptionsChanged(const OptionsNode &ANode);
+	void onApplicationAboutToQuit();
 private:
+	IPluginManager *FPluginManager;
 	IServiceDiscovery *FDiscovery;
 	INotifications *FNotifications;
 	IStanzaProcessor *FStanzaProcessor;
@@ -98,6 +115,11 @@ private:
 	QMultiMap<int, IMessageHandler *> FMessageHandlers;
 	QMultiMap<int, IMessageWriter *> FMessageWriters;
 	QMultiMap<int, IMessageEditor *> FMessageEditors;
+private:
+	mutable qint64 FTextCacheHits;
+	mutable qint64 FTextCacheMisses;
+	mutable qint64 FTextRenderTime;
+	mutable QCache<QByteArray, MessageTextCacheItem> FTextCache;
 };
 
 #endif // MESSAGEPROCESSOR_H
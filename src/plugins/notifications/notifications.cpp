@@ -279,8 +279,10 @@ int Notifications::appendNotification(const INotification &ANotification)
 
 	bool isAway = FStatusChanger!=NULL ? FStatusChanger->statusItemShow(STATUS_MAIN_ID)==IPresence::Away : false;
 	bool isDND = FStatusChanger!=NULL ? FStatusChanger->statusItemShow(STATUS_MAIN_ID)==IPresence::DoNotDisturb : false;
-	bool isSilent = isDND && Options::node(OPV_NOTIFICATIONS_SILENTIFDND).value().toBool();
-	isSilent = isSilent || (isAway && Options::node(OPV_NOTIFICATIONS_SILENTIFAWAY).value().toBool());
+	static const OptionsValue silentIfDnd(OPV_NOTIFICATIONS_SILENTIFDND);
+	static const OptionsValue silentIfAway(OPV_NOTIFICATIONS_SILENTIFAWAY);
+	bool isSilent = isDND && silentIfDnd.value().toBool();
+	isSilent = isSilent || (isAway && silentIfAway.value().toBool());
 
 	QIcon icon = qvariant_cast<QIcon>(record.notification.data.value(NDR_ICON));
 	QString toolTip = record.notification.data.value(NDR_TOOLTIP).toString();
@@ -312,7 +314,8 @@ int Notifications::appendNotification(const INotification &ANotification)
 				rnotify.icon = icon;
 				rnotify.order = record.notification.data.value(NDR_ROSTER_ORDER).toInt();
 				rnotify.flags = record.notification.data.value(NDR_ROSTER_FLAGS).toInt();
-				if (Options::node(OPV_NOTIFICATIONS_EXPANDGROUPS).value().toBool())
+				static const OptionsValue expandGroups(OPV_NOTIFICATIONS_EXPANDGROUPS);
+				if (expandGroups.value().toBool())
 					rnotify.flags |= IRostersNotify::ExpandParents;
 				rnotify.timeout = record.notification.data.value(NDR_ROSTER_TIMEOUT).toInt();
 				rnotify.footer = record.notification.data.value(NDR_ROSTER_FOOTER).toString();
@@ -20,6 +20,7 @@
 #include <utils/widgetmanager.h>
 #include <utils/filestorage.h>
 #include <utils/action.h>
+#include <utils/savefiletask.h>
 #include <utils/logger.h>
 
 #define DIR_PROFILES                    "profiles"
@@ -39,6 +40,7 @@
 #define ADR_PROFILE                     Action::DR_Parametr1
 
 #define AUTO_SAVE_TIMEOUT               5*60*1000
+#define SAVE_TIMEOUT                    10*1000
 
 
 static const int StandardLocationsCount = 11;
@@ -56,7 +58,6 @@ static const struct { QDesktopServices::StandardLocation location; QString key;
 	{ QDesktopServices::CacheLocation,          "%CacheLocation%"        },
 };
 
-
 OptionsManager::OptionsManager()
 {
 	FPluginManager = NULL;
@@ -67,6 +68,13 @@ OptionsManager::OptionsManager()
 	FAutoSaveTimer.setInterval(AUTO_SAVE_TIMEOUT);
 	connect(&FAutoSaveTimer, SIGNAL(timeout()),SLOT(onAutoSaveTimerTimeout()));
 
+	FSaveTimer.setSingleShot(true);
+	FSaveTimer.setInterval(SAVE_TIMEOUT);
+	connect(&FSaveTimer, SIGNAL(timeout()),SLOT(onSaveTimerTimeout()));
+
+	// Options files must be written in the same order as they were saved
+	FSaveThreadPool.setMaxThreadCount(1);
+
 	qsrand(QDateTime::currentDateTime().toTime_t());
 }
 
@@ -621,12 +629,13 @@ void OptionsManager::closeProfile()
 		LOG_INFO(QString("Closing profile=%1").arg(FProfile));
 		emit profileClosed(currentProfile());
 
+		FSaveTimer.stop();
 		FAutoSaveTimer.stop();
 		qDeleteAll(FOptionDialogs);
 		FShowOptionsDialogAction->setEnabled(false);
 
 		Options::setOptions(QDomDocument(), QString::null, QByteArray());
-		saveCurrentProfileOptions();
+		saveCurrentProfileOptions(false);
 
 		FProfile.clear();
 		FProfileKey.clear();
@@ -698,27 +707,27 @@ bool OptionsManager::saveProfile(const QString &AProfile, const QDomDocument &AP
 	return false;
 }
 
-bool OptionsManager::saveCurrentProfileOptions() const
+bool OptionsManager::saveCurrentProfileOptions(bool AAsync)
 {
 	if (isOpened())
 	{
-		QFile file(QDir(profilePath(FProfile)).filePath(FILE_OPTIONS));
-		if (file.open(QIODevice::WriteOnly|QIODevice::Truncate))
+		FSaveTimer.stop();
+
+		// QDomDocument is not thread safe, only file writing is moved to the thread pool
+		QString fileName = QDir(profilePath(FProfile)).filePath(FILE_OPTIONS);
+		QByteArray data = FProfileOptions.toByteArray();
+		if (AAsync)
 		{
-			QByteArray data = FProfileOptions.toByteArray();
-			if (file.write(data)==data.size() && file.flush())
-			{
-				LOG_DEBUG(QString("Current profile options saved, profile=%1").arg(FProfile));
-				return true;
-			}
-			else
-			{
-				REPORT_ERROR(QString("Failed to save current profile options to file: %1").arg(file.errorString()));
-			}
+			FSaveThreadPool.start(new SaveFileTask(fileName,data));
+			LOG_DEBUG(QString("Current profile options save started, profile=%1").arg(FProfile));
+			return true;
 		}
-		else
+
+		FSaveThreadPool.waitForDone();
+		if (SaveFileTask::saveFile(fileName,data))
 		{
-			REPORT_ERROR(QString("Failed to create current profile options file: %1").arg(file.errorString()));
+			LOG_DEBUG(QString("Current profile options saved, profile=%1").arg(FProfile));
+			return true;
 		}
 	}
 	else
@@ -823,6 +832,9 @@ void OptionsManager::updateOptionDefaults(const QMap<QString, QVariant> &AOption
 
 void OptionsManager::onOptionsChanged(const OptionsNode &ANode)
 {
+	if (isOpened() && !FSaveTimer.isActive())
+		FSaveTimer.start();
+
 	if (ANode.path() == OPV_COMMON_AUTOSTART)
 	{
 #ifdef Q_WS_WIN
@@ -868,6 +880,11 @@ void OptionsManager::onAutoSaveTimerTimeout()
 	saveCurrentProfileOptions();
 }
 
+void OptionsManager::onSaveTimerTimeout()
+{
+	saveCurrentProfileOptions();
+}
+
 void OptionsManager::onApplicationAboutToQuit()
 {
 	closeProfile();
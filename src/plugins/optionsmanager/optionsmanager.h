@@ -5,6 +5,7 @@
 #include <QFile>
 #include <QTimer>
 #include <QPointer>
+#include <QThreadPool>
 #include <interfaces/ipluginmanager.h>
 #include <interfaces/ioptionsmanager.h>
 #include <interfaces/imainwindow.h>
@@ -89,8 +90,7 @@ protected:
 	void openProfile(const QString &AProfile, const QString &APassword);
 	QDomDocument profileDocument(const QString &AProfile) const;
 	bool saveProfile(const QString &AProfile, const QDomDocument &AProfileDoc) const;
-	bool saveCurrentProfileOptions() const;
-protected:
+	bool saveCurrentProfileOptions(bool AAsync = true);
 	QMap<QString, QVariant> getOptionValues(const OptionsNode &ANode) const;
 	QMap<QString, QVariant> loadOptionValues(const QString &AFilePath) const;
 	QMap<QString, QVariant> loadAllOptionValues(const QString &AFileName) const;
@@ -103,6 +103,7 @@ protected slots:
 	void onShowOptionsDialogByAction(bool);
 	void onLoginDialogRejected();
 	void onAutoSaveTimerTimeout();
+	void onSaveTimerTimeout();
 	void onApplicationAboutToQuit();
 private:
 	ITrayManager *FTrayManager;
@@ -110,7 +111,9 @@ private:
 	IMainWindowPlugin *FMainWindowPlugin;
 private:
 	QDir FProfilesDir;
+	QTimer FSaveTimer;
 	QTimer FAutoSaveTimer;
+	QThreadPool FSaveThreadPool;
 private:
 	QString FProfile;
 	QByteArray FProfileKey;
@@ -2,6 +2,7 @@
 
 #include <QSet>
 #include <QFile>
+#include <QDataStream>
 #include <definitions/namespaces.h>
 #include <definitions/optionvalues.h>
 #include <definitions/internalerrors.h>
@@ -14,6 +15,9 @@
 #define SHC_ROSTER            "/iq[@type='set']/query[@xmlns='" NS_JABBER_ROSTER "']"
 #define SHC_PRESENCE          "/presence[@type]"
 
+#define ROSTER_FILE_MAGIC     0x52535452
+#define ROSTER_FILE_VERSION   1
+
 Roster::Roster(IXmppStream *AXmppStream, IStanzaProcessor *AStanzaProcessor) : QObject(AXmppStream->instance())
 {
 	FXmppStream = AXmppStream;
@@ -427,31 +431,19 @@ void Roster::removeItems(const QList<IRosterItem> &AItems)
 
 void Roster::saveRosterItems(const QString &AFileName) const
 {
-	QDomDocument xml;
-	QDomElement elem = xml.appendChild(xml.createElement("roster")).toElement();
-	elem.setAttribute("ver",FRosterVer);
-	elem.setAttribute("streamJid",streamJid().pBare());
-	elem.setAttribute("groupDelimiter",FGroupDelim);
+	QByteArray data;
+	QDataStream stream(&data,QIODevice::WriteOnly);
+	stream.setVersion(QDataStream::Qt_4_6);
+	stream << (quint32)ROSTER_FILE_MAGIC << (quint32)ROSTER_FILE_VERSION;
+	stream << streamJid().pBare() << FRosterVer << FGroupDelim << (quint32)FItems.count();
 	foreach(const IRosterItem &ritem, FItems)
-	{
-		QDomElement itemElem = elem.appendChild(xml.createElement("item")).toElement();
-		itemElem.setAttribute("jid",ritem.itemJid.bare());
-		itemElem.setAttribute("name",ritem.name);
-		itemElem.setAttribute("subscription",ritem.subscription);
-		itemElem.setAttribute("ask",ritem.subscriptionAsk);
-		foreach(QString group, ritem.groups)
-		{
-			group = replaceGroupDelimiter(group,ROSTER_GROUP_DELIMITER,FGroupDelim);
-			if (!group.isEmpty())
-				itemElem.appendChild(xml.createElement("group")).appendChild(xml.createTextNode(group));
-		}
-	}
+		stream << ritem.itemJid.bare() << ritem.name << ritem.subscription << ritem.subscriptionAsk << ritem.groups;
 
 	QFile file(AFileName);
 	if (file.open(QIODevice::WriteOnly | QIODevice::Truncate))
 	{
 		LOG_STRM_INFO(streamJid(),QString("Roster items saved to file=%1").arg(AFileName));
-		file.write(xml.toByteArray());
+		file.write(data);
 		file.close();
 	}
 	else
@@ -467,27 +459,69 @@ void Roster::loadRosterItems(const QString &AFileName)
 		QFile file(AFileName);
 		if (file.open(QIODevice::ReadOnly))
 		{
-			QString xmlError;
-			QDomDocument doc;
-			if (doc.setContent(&file,true,&xmlError))
+			quint32 magic = 0;
+			quint32 version = 0;
+			QDataStream stream(&file);
+			stream.setVersion(QDataStream::Qt_4_6);
+			stream >> magic >> version;
+			if (magic==ROSTER_FILE_MAGIC && version==ROSTER_FILE_VERSION)
 			{
-				QDomElement itemsElem = doc.firstChildElement("roster");
-				if (!itemsElem.isNull() && itemsElem.attribute("streamJid")==streamJid().pBare())
+				quint32 count = 0;
+				QString bareJid, rosterVer, groupDelim;
+				stream >> bareJid >> rosterVer >> groupDelim >> count;
+
+				QList<IRosterItem> items;
+				for (quint32 i=0; i<count && stream.status()==QDataStream::Ok; i++)
 				{
-					LOG_STRM_INFO(streamJid(),QString("Roster items loaded from file=%1").arg(AFileName));
-					setGroupDelimiter(itemsElem.attribute("groupDelimiter"));
-					processItemsElement(itemsElem,true);
+					QString itemJid;
+					IRosterItem ritem;
+					stream >> itemJid >> ritem.name >> ritem.subscription >> ritem.subscriptionAsk >> ritem.groups;
+					ritem.itemJid = itemJid;
+					items.append(ritem);
+				}
+
+				if (stream.status()!=QDataStream::Ok)
+				{
+					REPORT_ERROR("Failed to load roster items from file content: Invalid data");
+					file.remove();
 				}
-				else if (!itemsElem.isNull())
+				else if (bareJid != streamJid().pBare())
 				{
 					REPORT_ERROR("Failed to load roster items from file content: Invalid stream JID");
 					file.remove();
 				}
+				else
+				{
+					LOG_STRM_INFO(streamJid(),QString("Roster items loaded from file=%1").arg(AFileName));
+					setGroupDelimiter(groupDelim);
+					processItems(rosterVer,items,true);
+				}
 			}
 			else
 			{
-				REPORT_ERROR(QString("Failed to load roster items from file content: %1").arg(xmlError));
-				file.remove();
+				QString xmlError;
+				QDomDocument doc;
+				file.seek(0);
+				if (doc.setContent(&file,true,&xmlError))
+				{
+					QDomElement itemsElem = doc.firstChildElement("roster");
+					if (!itemsElem.isNull() && itemsElem.attribute("streamJid")==streamJid().pBare())
+					{
+						LOG_STRM_INFO(streamJid(),QString("Roster items loaded from XML file=%1").arg(AFileName));
+						setGroupDelimiter(itemsElem.attribute("groupDelimiter"));
+						processItemsElement(itemsElem,true);
+					}
+					else if (!itemsElem.isNull())
+					{
+						REPORT_ERROR("Failed to load roster items from file content: Invalid stream JID");
+						file.remove();
+					}
+				}
+				else
+				{
+					REPORT_ERROR(QString("Failed to load roster items from file content: %1").arg(xmlError));
+					file.remove();
+				}
 			}
 		}
 		else if (file.exists())
@@ -708,59 +742,69 @@ void Roster::processItemsElement(const QDomElement &AItemsElem, bool ACompleteRo
 {
 	if (!AItemsElem.isNull())
 	{
-		FRosterVer = AItemsElem.attribute("ver");
-		QSet<Jid> oldItems = ACompleteRoster ? FItems.keys().toSet() : QSet<Jid>();
+		QList<IRosterItem> items;
 		QDomElement itemElem = AItemsElem.firstChildElement("item");
 		while (!itemElem.isNull())
 		{
-			Jid itemJid = itemElem.attribute("jid");
-			if (itemJid.isValid() && !itemJid.hasResource())
+			IRosterItem ritem;
+			ritem.itemJid = itemElem.attribute("jid");
+			ritem.name = itemElem.attribute("name");
+			ritem.subscription = itemElem.attribute("subscription");
+			ritem.subscriptionAsk = itemElem.attribute("ask");
+
+			QDomElement groupElem = itemElem.firstChildElement("group");
+			while (!groupElem.isNull())
 			{
-				QString subs = itemElem.attribute("subscription");
-				if (subs==SUBSCRIPTION_BOTH || subs==SUBSCRIPTION_TO || subs==SUBSCRIPTION_FROM || subs==SUBSCRIPTION_NONE)
-				{
-					IRosterItem &ritem = FItems[itemJid];
-					IRosterItem before = ritem;
+				QString group = replaceGroupDelimiter(groupElem.text(),FGroupDelim,ROSTER_GROUP_DELIMITER);
+				if (!group.trimmed().isEmpty())
+					ritem.groups += group;
+				groupElem = groupElem.nextSiblingElement("group");
+			}
 
-					ritem.itemJid = itemJid;
-					ritem.name = itemElem.attribute("name");
-					ritem.subscription = subs;
-					ritem.subscriptionAsk = itemElem.attribute("ask");
-					oldItems -= ritem.itemJid;
-
-					QSet<QString> allItemGroups;
-					QDomElement groupElem = itemElem.firstChildElement("group");
-					while (!groupElem.isNull())
-					{
-						QString group = replaceGroupDelimiter(groupElem.text(),FGroupDelim,ROSTER_GROUP_DELIMITER);
-						if (!group.trimmed().isEmpty())
-							allItemGroups += group;
-						groupElem = groupElem.nextSiblingElement("group");
-					}
-					ritem.groups = allItemGroups;
+			items.append(ritem);
+			itemElem = itemElem.nextSiblingElement("item");
+		}
+		processItems(AItemsElem.attribute("ver"),items,ACompleteRoster);
+	}
+}
 
-					if (ritem != before)
-					{
-						LOG_STRM_DEBUG(streamJid(),QString("Roster item updated, jid=%1, name=%2, groups=%3, subscr=%4").arg(ritem.itemJid.bare(),ritem.name,QStringList(ritem.groups.toList()).join("; "),ritem.subscription));
-						emit itemReceived(ritem,before);
-					}
-				}
-				else if (subs == SUBSCRIPTION_REMOVE)
+void Roster::processItems(const QString &AVer, const QList<IRosterItem> &AItems, bool ACompleteRoster)
+{
+	FRosterVer = AVer;
+	QSet<Jid> oldItems = ACompleteRoster ? FItems.keys().toSet() : QSet<Jid>();
+	foreach(const IRosterItem &item, AItems)
+	{
+		if (item.itemJid.isValid() && !item.itemJid.hasResource())
+		{
+			const QString &subs = item.subscription;
+			if (subs==SUBSCRIPTION_BOTH || subs==SUBSCRIPTION_TO || subs==SUBSCRIPTION_FROM || subs==SUBSCRIPTION_NONE)
+			{
+				IRosterItem &ritem = FItems[item.itemJid];
+				IRosterItem before = ritem;
+
+				ritem = item;
+				oldItems -= ritem.itemJid;
+
+				if (ritem != before)
 				{
-					oldItems += itemJid;
+					LOG_STRM_DEBUG(streamJid(),QString("Roster item updated, jid=%1, name=%2, groups=%3, subscr=%4").arg(ritem.itemJid.bare(),ritem.name,QStringList(ritem.groups.toList()).join("; "),ritem.subscription));
+					emit itemReceived(ritem,before);
 				}
 			}
-			itemElem = itemElem.nextSiblingElement("item");
+			else if (subs == SUBSCRIPTION_REMOVE)
+			{
+				oldItems += item.itemJid;
+			}
 		}
+	}
 
-		foreach(const Jid &itemJid, oldItems) 
-		{
-			IRosterItem ritem = FItems.take(itemJid);
-			IRosterItem before = ritem;
-			ritem.subscription = SUBSCRIPTION_REMOVE;
-			LOG_STRM_DEBUG(streamJid(),QString("Roster item removed, jid=%1").arg(ritem.itemJid.bare()));
-			emit itemReceived(ritem,before);
-		}
+	foreach(const Jid &itemJid, oldItems) 
+	{
+		IRosterItem ritem = FItems.take(itemJid);
+		IRosterItem before = ritem;
+		ritem.subscription = SUBSCRIPTION_REMOVE;
+		LOG_STRM_DEBUG(streamJid(),QString("Roster item removed, jid=%1").arg(ritem.itemJid.bare()));
+		emit itemReceived(ritem,before);
 	}
 }
 
@@ -73,6 +73,7 @@ protected:
 	void requestGroupDelimiter();
 	void setGroupDelimiter(const QString &ADelimiter);
 	void processItemsElement(const QDomElement &AItemsElem, bool ACompleteRoster);
+	void processItems(const QString &AVer, const QList<IRosterItem> &AItems, bool ACompleteRoster);
 	QString replaceGroupDelimiter(const QString &AGroup, const QString &AFrom, const QString &ATo) const;
 protected slots:
 	void onXmppStreamOpened();
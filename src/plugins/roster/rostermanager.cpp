@@ -1,6 +1,8 @@
 #include "rostermanager.h"
 
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <definitions/optionvalues.h>
 #include <definitions/internalerrors.h>
 #include <utils/xmpperror.h>
@@ -114,7 +116,24 @@ QString RosterManager::rosterFileName(const Jid &AStreamJid) const
 	if (!dir.exists("rosters"))
 		dir.mkdir("rosters");
 	dir.cd("rosters");
-	return dir.absoluteFilePath(Jid::encode(AStreamJid.pBare())+".xml");
+	return dir.absoluteFilePath(Jid::encode(AStreamJid.pBare())+".dat");
+}
+
+void RosterManager::loadRosterItems(IRoster *ARoster) const
+{
+	QFileInfo fileInfo(rosterFileName(ARoster->streamJid()));
+
+	// Rosters were saved by previous versions in XML files, roster loads both formats
+	QString xmlFileName = fileInfo.dir().absoluteFilePath(fileInfo.completeBaseName()+".xml");
+	if (!fileInfo.exists() && QFile::exists(xmlFileName))
+	{
+		if (QFile::rename(xmlFileName,fileInfo.absoluteFilePath()))
+			LOG_STRM_INFO(ARoster->streamJid(),"Roster items file migrated from XML format");
+		else
+			LOG_STRM_WARNING(ARoster->streamJid(),"Failed to migrate roster items file from XML format");
+	}
+
+	ARoster->loadRosterItems(fileInfo.absoluteFilePath());
 }
 
 void RosterManager::onRosterOpened()
@@ -176,7 +195,7 @@ void RosterManager::onRosterStreamJidChanged(const Jid &ABefore)
 	{
 		emit rosterStreamJidChanged(roster,ABefore);
 		if (roster->streamJid().pBare() != ABefore.pBare())
-			roster->loadRosterItems(rosterFileName(roster->streamJid()));
+			loadRosterItems(roster);
 	}
 }
 
@@ -210,7 +229,7 @@ void RosterManager::onXmppStreamActiveChanged(IXmppStream *AXmppStream, bool AAc
 		connect(roster->instance(),SIGNAL(streamJidChanged(const Jid &)),
 			SLOT(onRosterStreamJidChanged(const Jid &)));
 		emit rosterActiveChanged(roster,AActive);
-		roster->loadRosterItems(rosterFileName(roster->streamJid()));
+		loadRosterItems(roster);
 	}
 	else if (!AActive && roster!=NULL)
 	{
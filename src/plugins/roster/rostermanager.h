@@ -42,6 +42,8 @@ signals:
 	void rosterStreamJidChanged(IRoster *ARoster, const Jid &ABefore);
 	void rosterActiveChanged(IRoster *ARoster, bool AActive);
 	void rosterDestroyed(IRoster *ARoster);
+protected:
+	void loadRosterItems(IRoster *ARoster) const;
 protected slots:
 	void onRosterOpened();
 	void onRosterClosed();
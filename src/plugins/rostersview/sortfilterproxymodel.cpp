@@ -11,6 +11,7 @@ SortFilterProxyModel::SortFilterProxyModel(IRostersViewPlugin *ARostersViewPlugi
 	FShowOffline = true;
 	FSortMode = IRostersView::SortByStatus;
 	FRostersView = ARostersViewPlugin->rostersView();
+	FRostersModel = NULL;
 }
 
 SortFilterProxyModel::~SortFilterProxyModel()
@@ -18,10 +19,43 @@ SortFilterProxyModel::~SortFilterProxyModel()
 
 }
 
+void SortFilterProxyModel::setSourceModel(QAbstractItemModel *ASourceModel)
+{
+	if (sourceModel())
+		disconnect(sourceModel(),0,this,0);
+	if (FRostersModel)
+		disconnect(FRostersModel->instance(),0,this,0);
+
+	FSortKeys.clear();
+	FRostersModel = NULL;
+
+	if (ASourceModel)
+	{
+		// Sort keys must be dropped before QSortFilterProxyModel handles the same signals
+		connect(ASourceModel,SIGNAL(dataChanged(const QModelIndex &, const QModelIndex &)),SLOT(onSourceDataChanged(const QModelIndex &, const QModelIndex &)));
+		connect(ASourceModel,SIGNAL(rowsInserted(const QModelIndex &, int, int)),SLOT(onSourceRowsInserted(const QModelIndex &, int, int)));
+		connect(ASourceModel,SIGNAL(layoutChanged()),SLOT(onSourceLayoutChanged()));
+		connect(ASourceModel,SIGNAL(modelReset()),SLOT(onSourceLayoutChanged()));
+
+		QAbstractItemModel *rootModel = ASourceModel;
+		for (QAbstractProxyModel *proxy = qobject_cast<QAbstractProxyModel *>(rootModel); proxy!=NULL; proxy = qobject_cast<QAbstractProxyModel *>(rootModel))
+			rootModel = proxy->sourceModel();
+
+		FRostersModel = qobject_cast<IRostersModel *>(rootModel);
+		if (FRostersModel)
+			connect(FRostersModel->instance(),SIGNAL(indexDestroyed(IRosterIndex *)),SLOT(onRostersModelIndexDestroyed(IRosterIndex *)));
+	}
+
+	QSortFilterProxyModel::setSourceModel(ASourceModel);
+}
+
 void SortFilterProxyModel::invalidate()
 {
-	FSortMode = Options::node(OPV_ROSTER_SORTMODE).value().toInt();
-	FShowOffline = Options::node(OPV_ROSTER_SHOWOFFLINE).value().toBool();
+	static const OptionsValue sortMode(OPV_ROSTER_SORTMODE);
+	static const OptionsValue showOffline(OPV_ROSTER_SHOWOFFLINE);
+	FSortMode = sortMode.value().toInt();
+	FShowOffline = showOffline.value().toBool();
+	FSortKeys.clear();
 	QSortFilterProxyModel::invalidate();
 }
 
@@ -61,20 +95,71 @@ bool SortFilterProxyModel::compareVariant( const QVariant &ALeft, const QVariant
 	return false;
 }
 
+IRosterIndex *SortFilterProxyModel::mapToRosterIndex(const QModelIndex &ASourceIndex) const
+{
+	if (FRostersModel && ASourceIndex.isValid())
+	{
+		QModelIndex index = ASourceIndex;
+		for (const QAbstractProxyModel *proxy = qobject_cast<const QAbstractProxyModel *>(index.model()); proxy!=NULL; proxy = qobject_cast<const QAbstractProxyModel *>(index.model()))
+			index = proxy->mapToSource(index);
+		if (index.model() == FRostersModel->instance())
+			return FRostersModel->rosterIndexFromModelIndex(index);
+	}
+	return NULL;
+}
+
+SortFilterProxyModel::SortKey SortFilterProxyModel::sortKey(const QModelIndex &ASourceIndex) const
+{
+	IRosterIndex *index = mapToRosterIndex(ASourceIndex);
+	if (index != NULL)
+	{
+		QHash<const IRosterIndex *, SortKey>::const_iterator it = FSortKeys.constFind(index);
+		if (it != FSortKeys.constEnd())
+			return it.value();
+	}
+
+	SortKey key;
+	key.kindOrder = ASourceIndex.data(RDR_KIND_ORDER).toInt();
+	key.show = ASourceIndex.data(RDR_SHOW).toInt();
+	key.sortOrder = ASourceIndex.data(RDR_SORT_ORDER);
+	key.display = ASourceIndex.data(Qt::DisplayRole);
+
+	if (index != NULL)
+		FSortKeys.insert(index,key);
+
+	return key;
+}
+
+void SortFilterProxyModel::removeSortKeys(const QModelIndex &ASourceParent, int AStart, int AEnd)
+{
+	for (int row=AStart; row<=AEnd; row++)
+	{
+		QModelIndex index = sourceModel()->index(row,0,ASourceParent);
+		FSortKeys.remove(mapToRosterIndex(index));
+
+		int childCount = sourceModel()->rowCount(index);
+		if (childCount > 0)
+			removeSortKeys(index,0,childCount-1);
+	}
+}
+
 bool SortFilterProxyModel::lessThan(const QModelIndex &ALeft, const QModelIndex &ARight) const
 {
-	int leftTypeOrder = ALeft.data(RDR_KIND_ORDER).toInt();
-	int rightTypeOrder = ARight.data(RDR_KIND_ORDER).toInt();
+	const SortKey leftKey = sortKey(ALeft);
+	const SortKey rightKey = sortKey(ARight);
+
+	int leftTypeOrder = leftKey.kindOrder;
+	int rightTypeOrder = rightKey.kindOrder;
 	if (leftTypeOrder == rightTypeOrder)
 	{
-		QVariant leftSortOrder = ALeft.data(RDR_SORT_ORDER);
-		QVariant rightSortOrder = ARight.data(RDR_SORT_ORDER);
+		const QVariant &leftSortOrder = leftKey.sortOrder;
+		const QVariant &rightSortOrder = rightKey.sortOrder;
 		if (leftSortOrder.isNull() || rightSortOrder.isNull() || leftSortOrder==rightSortOrder)
 		{
 			if (FSortMode==IRostersView::SortByStatus && leftTypeOrder!=RIKO_STREAM_ROOT)
 			{
-				int leftShow = ALeft.data(RDR_SHOW).toInt();
-				int rightShow = ARight.data(RDR_SHOW).toInt();
+				int leftShow = leftKey.show;
+				int rightShow = rightKey.show;
 				if (leftShow != rightShow)
 				{
 					static const int show2order[] = {6,2,1,3,5,4,7,8};
@@ -83,7 +168,7 @@ bool SortFilterProxyModel::lessThan(const QModelIndex &ALeft, const QModelIndex
 						return show2order[leftShow] < show2order[rightShow];
 				}
 			}
-			return compareVariant(ALeft.data(Qt::DisplayRole),ARight.data(Qt::DisplayRole));
+			return compareVariant(leftKey.display,rightKey.display);
 		}
 		return compareVariant(leftSortOrder,rightSortOrder);
 	}
@@ -119,3 +204,25 @@ bool SortFilterProxyModel::filterAcceptsRow(int AModelRow, const QModelIndex &AM
 
 	return true;
 }
+
+void SortFilterProxyModel::onSourceDataChanged(const QModelIndex &ATopLeft, const QModelIndex &ABottomRight)
+{
+	for (int row=ATopLeft.row(); row<=ABottomRight.row(); row++)
+		FSortKeys.remove(mapToRosterIndex(ATopLeft.sibling(row,0)));
+}
+
+void SortFilterProxyModel::onSourceRowsInserted(const QModelIndex &AParent, int AStart, int AEnd)
+{
+	// Data of rows hidden by previous proxy models could be changed without notification
+	removeSortKeys(AParent,AStart,AEnd);
+}
+
+void SortFilterProxyModel::onSourceLayoutChanged()
+{
+	FSortKeys.clear();
+}
+
+void SortFilterProxyModel::onRostersModelIndexDestroyed(IRosterIndex *AIndex)
+{
+	FSortKeys.remove(AIndex);
+}
@@ -1,29 +1,48 @@
 #ifndef SORTFILTERPROXYMODEL_H
 #define SORTFILTERPROXYMODEL_H
 
+#include <QHash>
 #include <QSortFilterProxyModel>
 #include <interfaces/irostersview.h>
+#include <interfaces/irostersmodel.h>
 #include <interfaces/ipresencemanager.h>
 
 class SortFilterProxyModel :
 	public QSortFilterProxyModel
 {
 	Q_OBJECT;
+	struct SortKey {
+		int kindOrder;
+		int show;
+		QVariant sortOrder;
+		QVariant display;
+	};
 public:
 	SortFilterProxyModel(IRostersViewPlugin *ARostersViewPlugin, QObject *AParent = NULL);
 	~SortFilterProxyModel();
+	void setSourceModel(QAbstractItemModel *ASourceModel);
 public slots:
 	void invalidate();
 protected:
 	bool compareVariant(const QVariant &ALeft, const QVariant &ARight) const;
+	IRosterIndex *mapToRosterIndex(const QModelIndex &ASourceIndex) const;
+	SortKey sortKey(const QModelIndex &ASourceIndex) const;
+	void removeSortKeys(const QModelIndex &ASourceParent, int AStart, int AEnd);
 protected:
 	bool lessThan(const QModelIndex &ALeft, const QModelIndex &ARight) const;
 	bool filterAcceptsRow(int AModelRow, const QModelIndex &AModelParent) const;
+protected slots:
+	void onSourceDataChanged(const QModelIndex &ATopLeft, const QModelIndex &ABottomRight);
+	void onSourceRowsInserted(const QModelIndex &AParent, int AStart, int AEnd);
+	void onSourceLayoutChanged();
+	void onRostersModelIndexDestroyed(IRosterIndex *AIndex);
 private:
 	IRostersView *FRostersView;
+	IRostersModel *FRostersModel;
 private:
 	int FSortMode;
 	bool FShowOffline;
+	mutable QHash<const IRosterIndex *, SortKey> FSortKeys;
 };
 
 #endif // SORTFILTERPROXYMODEL_H
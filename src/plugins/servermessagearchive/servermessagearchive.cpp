@@ -349,8 +349,9 @@ QString ServerMessageArchive::loadHeaders(const Jid &AStreamJid, const IArchiveR
 	return QString::null;
 }
 
-QString ServerMessageArchive::loadCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader)
+QString ServerMessageArchive::loadCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader, int ALastMessages)
 {
+	Q_UNUSED(ALastMessages);
 	QString id = loadServerCollection(AStreamJid,AHeader);
 	if (!id.isEmpty())
 	{
@@ -86,7 +86,7 @@ public:
 	virtual bool saveNote(const Jid &AStreamJid, const Message &AMessage, bool ADirectionIn);
 	virtual QString saveCollection(const Jid &AStreamJid, const IArchiveCollection &ACollection);
 	virtual QString loadHeaders(const Jid &AStreamJid, const IArchiveRequest &ARequest);
-	virtual QString loadCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader);
+	virtual QString loadCollection(const Jid &AStreamJid, const IArchiveHeader &AHeader, int ALastMessages = -1);
 	virtual QString removeCollections(const Jid &AStreamJid, const IArchiveRequest &ARequest);
 	virtual QString loadModifications(const Jid &AStreamJid, const QDateTime &AStart, int ACount, const QString &ANextRef);
 	//IServerMesssageArchive
@@ -19,6 +19,7 @@
 #include <definitions/discofeaturehandlerorders.h>
 #include <utils/widgetmanager.h>
 #include <utils/iconstorage.h>
+#include <utils/savefiletask.h>
 #include <utils/logger.h>
 
 #define SHC_DISCO_INFO          "/iq[@type='get']/query[@xmlns='" NS_DISCO_INFO "']"
@@ -62,6 +63,8 @@ ServiceDiscovery::ServiceDiscovery()
 	FDiscoMenu = NULL;
 	FUpdateSelfCapsStarted = false;
 
+	FCapsSaveThreadPool.setMaxThreadCount(1);
+
 
 	FQueueTimer.setSingleShot(true);
 	FQueueTimer.setInterval(QUEUE_TIMEOUT);
@@ -72,6 +75,7 @@ ServiceDiscovery::ServiceDiscovery()
 
 ServiceDiscovery::~ServiceDiscovery()
 {
+	FCapsSaveThreadPool.waitForDone();
 	delete FDiscoMenu;
 }
 
@@ -195,6 +199,9 @@ bool ServiceDiscovery::initObjects()
 		FCapsFilesDir.mkdir(CAPS_DIRNAME);
 	FCapsFilesDir.cd(CAPS_DIRNAME);
 
+	foreach(const QString &fileName, FCapsFilesDir.entryList(QStringList()<<"*.xml",QDir::Files))
+		FCapsFiles += FCapsFilesDir.absoluteFilePath(fileName);
+
 	FDiscoMenu = new Menu;
 	FDiscoMenu->setIcon(RSR_STORAGE_MENUICONS,MNI_SDISCOVERY_DISCOVER);
 	FDiscoMenu->setTitle(tr("Service Discovery"));
@@ -1004,7 +1011,7 @@ void ServiceDiscovery::removeQueuedRequest(const DiscoveryRequest &ARequest)
 
 bool ServiceDiscovery::hasEntityCaps(const EntityCapabilities &ACaps) const
 {
-	return QFile::exists(capsFileName(ACaps,false)) || QFile::exists(capsFileName(ACaps,true));
+	return FCapsFiles.contains(capsFileName(ACaps,false)) || FCapsFiles.contains(capsFileName(ACaps,true));
 }
 
 QString ServiceDiscovery::capsFileName(const EntityCapabilities &ACaps, bool AWithOwner) const
@@ -1015,51 +1022,49 @@ QString ServiceDiscovery::capsFileName(const EntityCapabilities &ACaps, bool AWi
 	return FCapsFilesDir.absoluteFilePath(fileName);
 }
 
-IDiscoInfo ServiceDiscovery::loadCapsInfo(const EntityCapabilities &ACaps) const
+IDiscoInfo ServiceDiscovery::loadCapsInfo(const EntityCapabilities &ACaps)
 {
-	// Check if present another user with same correct calculated caps and loaded discovery info
-	QHash<Jid, EntityCapabilities> streamEntityCaps = FEntityCaps.value(ACaps.streamJid);
-	for(QHash<Jid, EntityCapabilities>::const_iterator it=streamEntityCaps.constBegin(); it!=streamEntityCaps.constEnd(); ++it)
-	{
-		if ((!ACaps.hash.isEmpty() || ACaps.node==it->node) && ACaps.ver==it->ver && ACaps.hash==it->hash && hasDiscoInfo(it->streamJid,it->entityJid))
-		{
-			IDiscoInfo dinfo = discoInfo(it->streamJid,it->entityJid);
-			if (!it->ver.isEmpty() && it->ver==calcCapsHash(dinfo,it->hash))
-				return dinfo;
-		}
-	}
-
-	// Load discovery info from file
+	// Caps info is read from file only once and then kept in memory
 	IDiscoInfo dinfo;
 	foreach(const QString &fileName, QStringList() << capsFileName(ACaps,true) << capsFileName(ACaps,false))
 	{
-		QFile file(fileName);
-		if (file.open(QIODevice::ReadOnly))
+		if (FCapsInfo.contains(fileName))
 		{
-			QString xmlError;
-			QDomDocument doc;
-			if (doc.setContent(&file,true,&xmlError))
+			dinfo = FCapsInfo.value(fileName);
+			break;
+		}
+		else if (FCapsFiles.contains(fileName))
+		{
+			QFile file(fileName);
+			if (file.open(QIODevice::ReadOnly))
 			{
-				QDomElement capsElem = doc.documentElement();
-				discoInfoFromElem(capsElem,dinfo);
-				break;
+				QString xmlError;
+				QDomDocument doc;
+				if (doc.setContent(&file,true,&xmlError))
+				{
+					QDomElement capsElem = doc.documentElement();
+					discoInfoFromElem(capsElem,dinfo);
+					FCapsInfo.insert(fileName,dinfo);
+					break;
+				}
+				else
+				{
+					REPORT_ERROR(QString("Failed to load caps info from file content: %1").arg(xmlError));
+					FCapsFiles.remove(fileName);
+					file.remove();
+				}
 			}
 			else
 			{
-				REPORT_ERROR(QString("Failed to load caps info from file content: %1").arg(xmlError));
-				file.remove();
+				REPORT_ERROR(QString("Failed to load caps info from file: %1").arg(file.errorString()));
+				FCapsFiles.remove(fileName);
 			}
 		}
-		else if (file.exists())
-		{
-			REPORT_ERROR(QString("Failed to load caps info from file: %1").arg(file.errorString()));
-		}
 	}
-
 	return dinfo;
 }
 
-bool ServiceDiscovery::saveCapsInfo(const IDiscoInfo &AInfo) const
+bool ServiceDiscovery::saveCapsInfo(const IDiscoInfo &AInfo)
 {
 	if (AInfo.error.isNull() && FEntityCaps.value(AInfo.streamJid).contains(AInfo.contactJid))
 	{
@@ -1080,16 +1085,16 @@ bool ServiceDiscovery::saveCapsInfo(const IDiscoInfo &AInfo) const
 				if (!checked)
 					capsElem.setAttribute("jid",caps.owner);
 
-				QFile file(capsFileName(caps,!checked));
-				if (file.open(QIODevice::WriteOnly|QIODevice::Truncate))
-				{
-					file.write(doc.toByteArray());
-					file.close();
-				}
-				else
-				{
-					REPORT_ERROR(QString("Failed to save caps info to file: %1").arg(file.errorString()));
-				}
+				QString fileName = capsFileName(caps,!checked);
+				// Cached info should be the same as loaded from file, without contact specific fields
+				IDiscoInfo capsInfo = AInfo;
+				capsInfo.streamJid = Jid::null;
+				capsInfo.contactJid = Jid::null;
+				capsInfo.node = QString::null;
+
+				FCapsFiles += fileName;
+				FCapsInfo.insert(fileName,capsInfo);
+				FCapsSaveThreadPool.start(new SaveFileTask(fileName,doc.toByteArray()));
 			}
 			return true;
 		}
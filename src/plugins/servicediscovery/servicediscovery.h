@@ -7,6 +7,7 @@
 #include <QPair>
 #include <QTimer>
 #include <QMultiMap>
+#include <QThreadPool>
 #include <interfaces/ipluginmanager.h>
 #include <interfaces/iservicediscovery.h>
 #include <interfaces/ixmppstreammanager.h>
@@ -135,8 +136,8 @@ protected:
 	void removeQueuedRequest(const DiscoveryRequest &ARequest);
 	bool hasEntityCaps(const EntityCapabilities &ACaps) const;
 	QString capsFileName(const EntityCapabilities &ACaps, bool AWithOwner) const;
-	IDiscoInfo loadCapsInfo(const EntityCapabilities &ACaps) const;
-	bool saveCapsInfo(const IDiscoInfo &AInfo) const;
+	IDiscoInfo loadCapsInfo(const EntityCapabilities &ACaps);
+	bool saveCapsInfo(const IDiscoInfo &AInfo);
 	QString calcCapsHash(const IDiscoInfo &AInfo, const QString &AHash) const;
 	bool compareIdentities(const QList<IDiscoIdentity> &AIdentities, const IDiscoIdentity &AWith) const;
 	bool compareFeatures(const QStringList &AFeatures, const QStringList &AWith) const;
@@ -185,6 +186,9 @@ private:
 	QMultiMap<QDateTime, DiscoveryRequest> FQueuedRequests;
 private:
 	QDir FCapsFilesDir;
+	QSet<QString> FCapsFiles;
+	QHash<QString, IDiscoInfo> FCapsInfo;
+	QThreadPool FCapsSaveThreadPool;
 	bool FUpdateSelfCapsStarted;
 	QMap<Jid, EntityCapabilities> FSelfCaps;
 	QMap<Jid, QHash<Jid, EntityCapabilities> > FEntityCaps;
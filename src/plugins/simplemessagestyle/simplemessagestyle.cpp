@@ -18,6 +18,8 @@
 #define CONSECUTIVE_TIMEOUT                 2*60
 
 #define SCROLL_TIMEOUT                      100
+#define SCROLLBACK_PAGE_SIZE                20
+#define SCROLLBACK_MAX_MESSAGES             1000
 #define SHARED_STYLE_PATH                   RESOURCES_DIR "/" RSR_STORAGE_SIMPLEMESSAGESTYLES "/" FILE_STORAGE_SHARED_DIR
 
 static const char *SenderColors[] =  {
@@ -143,11 +145,13 @@ bool SimpleMessageStyle::changeOptions(QWidget *AWidget, const IMessageStyleOpti
 			wstatus.lastTime = QDateTime();
 			wstatus.scrollStarted = false;
 			wstatus.content.clear();
+			wstatus.scrollback.clear();
 			wstatus.options = AOptions.extended;
 
 			if (isNewView)
 			{
 				view->installEventFilter(this);
+				connect(view->verticalScrollBar(),SIGNAL(valueChanged(int)),SLOT(onStyleWidgetScrollValueChanged(int)),Qt::UniqueConnection);
 				connect(view,SIGNAL(anchorClicked(const QUrl &)),SLOT(onStyleWidgetLinkClicked(const QUrl &)));
 				connect(view,SIGNAL(destroyed(QObject *)),SLOT(onStyleWidgetDestroyed(QObject *)));
 				emit widgetAdded(view);
@@ -194,17 +198,26 @@ bool SimpleMessageStyle::appendContent(QWidget *AWidget, const QString &AHtml, c
 	if (view)
 	{
 		WidgetStatus &wstatus = FWidgetStatus[AWidget];
-		bool scrollAtEnd = !AOptions.noScroll && view->verticalScrollBar()->sliderPosition()==view->verticalScrollBar()->maximum();
+		bool sliderAtEnd = view->verticalScrollBar()->sliderPosition()==view->verticalScrollBar()->maximum();
+		bool scrollAtEnd = !AOptions.noScroll && sliderAtEnd;
 
+		// Content is not trimmed while user reads history above the end of the window
 		QTextCursor cursor(view->document());
-		int maxMessages = Options::node(OPV_MESSAGES_MAXMESSAGESINWINDOW).value().toInt();
-		if (maxMessages>0 && wstatus.content.count()>maxMessages+10)
+		static const OptionsValue maxMessagesInWindow(OPV_MESSAGES_MAXMESSAGESINWINDOW);
+		int maxMessages = maxMessagesInWindow.value().toInt();
+		if (maxMessages>0 && sliderAtEnd && wstatus.content.count()>maxMessages+10)
 		{
 			int scrollMax = view->verticalScrollBar()->maximum();
 
 			int removeSize = 0;
 			while(wstatus.content.count() > maxMessages)
-				removeSize += wstatus.content.takeFirst().size;
+			{
+				ContentItem removed = wstatus.content.takeFirst();
+				removeSize += removed.size;
+				wstatus.scrollback.append(removed);
+			}
+			while (wstatus.scrollback.count() > SCROLLBACK_MAX_MESSAGES)
+				wstatus.scrollback.removeFirst();
 
 			cursor.setPosition(wstatus.contentStartPosition);
 			cursor.setPosition(wstatus.contentStartPosition+removeSize,QTextCursor::KeepAnchor);
@@ -226,6 +239,7 @@ bool SimpleMessageStyle::appendContent(QWidget *AWidget, const QString &AHtml, c
 		int startPos = cursor.position();
 		cursor.insertHtml(content);
 		item.size = cursor.position()-startPos;
+		item.html = content;
 
 		if (scrollAtEnd)
 			view->verticalScrollBar()->setSliderPosition(view->verticalScrollBar()->maximum());
@@ -551,6 +565,28 @@ QString SimpleMessageStyle::prepareMessage(const QString &AHtml, const IMessageS
 	return AHtml;
 }
 
+void SimpleMessageStyle::insertScrollbackContent(StyleViewer *AView, WidgetStatus &AStatus)
+{
+	QScrollBar *scrollBar = AView->verticalScrollBar();
+	int scrollMax = scrollBar->maximum();
+	int scrollPos = scrollBar->sliderPosition();
+
+	QList<ContentItem> page = AStatus.scrollback.mid(qMax(AStatus.scrollback.count()-SCROLLBACK_PAGE_SIZE,0));
+	AStatus.scrollback.erase(AStatus.scrollback.end()-page.count(),AStatus.scrollback.end());
+
+	QTextCursor cursor(AView->document());
+	cursor.setPosition(AStatus.contentStartPosition);
+	for (QList<ContentItem>::iterator it=page.begin(); it!=page.end(); ++it)
+	{
+		int startPos = cursor.position();
+		cursor.insertHtml(it->html);
+		it->size = cursor.position()-startPos;
+	}
+	AStatus.content = page + AStatus.content;
+
+	scrollBar->setSliderPosition(scrollPos+scrollBar->maximum()-scrollMax);
+}
+
 bool SimpleMessageStyle::eventFilter(QObject *AWatched, QEvent *AEvent)
 {
 	if (AEvent->type() == QEvent::Resize)
@@ -604,3 +640,20 @@ void SimpleMessageStyle::onStyleWidgetAdded(IMessageStyle *AStyle, QWidget *AWid
 		emit widgetRemoved(AWidget);
 	}
 }
+
+void SimpleMessageStyle::onStyleWidgetScrollValueChanged(int AValue)
+{
+	QScrollBar *scrollBar = qobject_cast<QScrollBar *>(sender());
+	if (scrollBar!=NULL && AValue==scrollBar->minimum())
+	{
+		for (QMap<QWidget*,WidgetStatus>::iterator it = FWidgetStatus.begin(); it!= FWidgetStatus.end(); ++it)
+		{
+			StyleViewer *view = qobject_cast<StyleViewer *>(it.key());
+			if (view->verticalScrollBar()==scrollBar && !it->scrollback.isEmpty())
+			{
+				insertScrollbackContent(view,*it);
+				break;
+			}
+		}
+	}
+}
@@ -66,6 +66,7 @@ class SimpleMessageStyle :
 public:
 	struct ContentItem {
 		int size;
+		QString html;
 	};
 	struct WidgetStatus {
 		int lastKind;
@@ -74,6 +75,7 @@ public:
 		bool scrollStarted;
 		int contentStartPosition;
 		QList<ContentItem> content;
+		QList<ContentItem> scrollback;
 		QMap<QString, QVariant> options;
 	};
 public:
@@ -117,6 +119,7 @@ protected:
 	QString makeContentTemplate(const IMessageStyleContentOptions &AOptions, const WidgetStatus &AStatus) const;
 	void fillContentKeywords(QString &AHtml, const IMessageStyleContentOptions &AOptions, const WidgetStatus &AStatus) const;
 	QString prepareMessage(const QString &AHtml, const IMessageStyleContentOptions &AOptions) const;
+	void insertScrollbackContent(StyleViewer *AView, WidgetStatus &AStatus);
 protected:
 	bool eventFilter(QObject *AWatched, QEvent *AEvent);
 protected slots:
@@ -124,6 +127,7 @@ protected slots:
 	void onStyleWidgetLinkClicked(const QUrl &AUrl);
 	void onStyleWidgetDestroyed(QObject *AObject);
 	void onStyleWidgetAdded(IMessageStyle *AStyle, QWidget *AWidget);
+	void onStyleWidgetScrollValueChanged(int AValue);
 private:
 	QTimer FScrollTimer;
 	bool FCombineConsecutive;
@@ -20,7 +20,8 @@
 #define TCP_CLOSE_TIMEOUT         200
 
 #define BUFFER_INCREMENT_SIZE     5120
-#define MAX_BUFFER_SIZE           51200
+#define MIN_BUFFER_SIZE           51200
+#define MAX_BUFFER_SIZE           2097152
 
 #define SHC_HOSTS                 "/iq[@type='set']/query[@xmlns='" NS_SOCKS5_BYTESTREAMS "']"
 
@@ -58,7 +59,7 @@ QEvent::Type DataEvent::FEventType = static_cast<QEvent::Type>(QEvent::registerE
 
 // SocksStream
 SocksStream::SocksStream(ISocksStreams *ASocksStreams, IStanzaProcessor *AStanzaProcessor, const QString &AStreamId, const Jid &AStreamJid, const Jid &AContactJid, int AKind, QObject *AParent) 
-	: QIODevice(AParent), FReadBuffer(BUFFER_INCREMENT_SIZE), FWriteBuffer(BUFFER_INCREMENT_SIZE,MAX_BUFFER_SIZE)
+	: QIODevice(AParent), FReadBuffer(BUFFER_INCREMENT_SIZE), FWriteBuffer(BUFFER_INCREMENT_SIZE,MIN_BUFFER_SIZE)
 {
 	FSocksStreams = ASocksStreams;
 	FStanzaProcessor = AStanzaProcessor;
@@ -71,6 +72,7 @@ SocksStream::SocksStream(ISocksStreams *ASocksStreams, IStanzaProcessor *AStanza
 
 	FTcpSocket = NULL;
 	FConnectTimeout = 10000;
+	FReadWindowSize = MIN_BUFFER_SIZE;
 	FDirectEnabled = false;
 
 	FSHIHosts= -1;
@@ -557,23 +559,41 @@ void SocksStream::writeBufferedData(bool AFlush)
 {
 	if (FTcpSocket && isOpen())
 	{
-		FThreadLock.lockForRead();
-		qint64 dataSize = AFlush ? FWriteBuffer.size() : qMin((qint64)FWriteBuffer.size(), qint64(MAX_BUFFER_SIZE)-FTcpSocket->bytesToWrite());
+		FThreadLock.lockForWrite();
+
+		// Socket was drained while the stream buffer is full, so the window limits the speed
+		int windowSize = FWriteBuffer.maximumSize();
+		if (!AFlush && windowSize<MAX_BUFFER_SIZE && FWriteBuffer.size()>=windowSize && FTcpSocket->bytesToWrite()==0)
+		{
+			windowSize = qMin(windowSize*2,MAX_BUFFER_SIZE);
+			FWriteBuffer.setMaximumSize(windowSize);
+			LOG_STRM_DEBUG(FStreamJid,QString("Socks stream write window increased, sid=%1, size=%2").arg(FStreamId).arg(windowSize));
+		}
+
+		bool failed = false;
+		qint64 writtenSize = 0;
+		qint64 dataSize = AFlush ? FWriteBuffer.size() : qMin((qint64)FWriteBuffer.size(), qint64(windowSize)-FTcpSocket->bytesToWrite());
+		while (!failed && writtenSize<dataSize)
+		{
+			// Data is written directly from buffer blocks without intermediate copy
+			qint64 blockSize = qMin((qint64)FWriteBuffer.nextDataBlockSize(), dataSize-writtenSize);
+			failed = FTcpSocket->write(FWriteBuffer.readPointer(),blockSize) != blockSize;
+			FWriteBuffer.skip(blockSize);
+			writtenSize += blockSize;
+		}
+
 		FThreadLock.unlock();
 
-		if (dataSize > 0)
+		if (writtenSize > 0)
 		{
-			FThreadLock.lockForWrite();
-			QByteArray data = FWriteBuffer.read(dataSize);
-			FThreadLock.unlock();
 			FBytesWrittenCondition.wakeAll();
 
-			if (FTcpSocket->write(data) != data.size())
+			if (failed)
 				abort(XmppError(IERR_SOCKS5_STREAM_DATA_NOT_SENT));
 			else if (AFlush)
 				FTcpSocket->flush();
 
-			emit bytesWritten(data.size());
+			emit bytesWritten(writtenSize);
 		}
 	}
 }
@@ -582,16 +602,30 @@ void SocksStream::readBufferedData(bool AFlush)
 {
 	if (FTcpSocket && isOpen())
 	{
-		FThreadLock.lockForRead();
-		qint64 dataSize = AFlush ? FTcpSocket->bytesAvailable() : qMin(FTcpSocket->bytesAvailable(), qint64(MAX_BUFFER_SIZE)-FReadBuffer.size());
-		FThreadLock.unlock();
+		FThreadLock.lockForWrite();
+
+		// Stream buffer was drained while socket has more data, so the window limits the speed
+		if (!AFlush && FReadWindowSize<MAX_BUFFER_SIZE && FReadBuffer.size()==0 && FTcpSocket->bytesAvailable()>FReadWindowSize)
+		{
+			FReadWindowSize = qMin(FReadWindowSize*2,MAX_BUFFER_SIZE);
+			LOG_STRM_DEBUG(FStreamJid,QString("Socks stream read window increased, sid=%1, size=%2").arg(FStreamId).arg(FReadWindowSize));
+		}
 
+		qint64 readSize = 0;
+		qint64 dataSize = AFlush ? FTcpSocket->bytesAvailable() : qMin(FTcpSocket->bytesAvailable(), qint64(FReadWindowSize)-FReadBuffer.size());
 		if (dataSize > 0)
 		{
-			FThreadLock.lockForWrite();
-			FReadBuffer.write(FTcpSocket->read(dataSize));
-			FThreadLock.unlock();
+			// Data is read directly into buffer without intermediate copy
+			char *data = FReadBuffer.reserve(dataSize);
+			readSize = qMax(FTcpSocket->read(data,dataSize),qint64(0));
+			if (readSize < dataSize)
+				FReadBuffer.chop(dataSize-readSize);
+		}
 
+		FThreadLock.unlock();
+
+		if (readSize > 0)
+		{
 			FReadyReadCondition.wakeAll();
 			emit readyRead();
 		}
@@ -130,6 +130,7 @@ private:
 	QTcpSocket *FTcpSocket;
 	QList<HostInfo> FHosts;
 private:
+	int FReadWindowSize;
 	RingBuffer FReadBuffer;
 	RingBuffer FWriteBuffer;
 	mutable QReadWriteLock FThreadLock;
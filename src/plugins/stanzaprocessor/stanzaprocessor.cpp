@@ -7,6 +7,117 @@
 static const QStringList IqRequestTypes = QStringList() << STANZA_TYPE_SET << STANZA_TYPE_GET;
 static const QStringList IqReplyTypes = QStringList() << STANZA_TYPE_RESULT << STANZA_TYPE_ERROR;
 
+#define MAX_CONDITION_CACHE_SIZE   100
+
+class DomElementCursor
+{
+public:
+	DomElementCursor(const QDomElement &AElem) {
+		FElem = AElem;
+	}
+	bool isNull() const {
+		return FElem.isNull();
+	}
+	QString tagName() const {
+		return FElem.tagName();
+	}
+	bool attributeValue(const QString &AName, QString &AValue) const {
+		if (FElem.hasAttribute(AName))
+			AValue = FElem.attribute(AName);
+		else if (AName == "xmlns")
+			AValue = FElem.namespaceURI();
+		else
+			return false;
+		return true;
+	}
+	DomElementCursor firstChildElement() const {
+		return DomElementCursor(FElem.firstChildElement());
+	}
+	DomElementCursor nextSiblingElement(const QString &ATagName) const {
+		return DomElementCursor(FElem.nextSiblingElement(ATagName));
+	}
+private:
+	QDomElement FElem;
+};
+
+class TreeElementCursor
+{
+public:
+	TreeElementCursor(const StanzaTree *ATree, int ANode) {
+		FTree = ATree;
+		FNode = ANode;
+	}
+	bool isNull() const {
+		return FNode < 0;
+	}
+	QString tagName() const {
+		return FTree->tagName(FNode);
+	}
+	bool attributeValue(const QString &AName, QString &AValue) const {
+		if (FTree->hasAttribute(FNode,AName))
+			AValue = FTree->attribute(FNode,AName);
+		else if (AName == "xmlns")
+			AValue = FTree->namespaceURI(FNode);
+		else
+			return false;
+		return true;
+	}
+	TreeElementCursor firstChildElement() const {
+		return TreeElementCursor(FTree,FTree->firstChildElement(FNode));
+	}
+	TreeElementCursor nextSiblingElement(const QString &ATagName) const {
+		return TreeElementCursor(FTree,FTree->nextSiblingElement(FNode,ATagName));
+	}
+private:
+	int FNode;
+	const StanzaTree *FTree;
+};
+
+template<class Cursor>
+static bool matchConditionStep(const Cursor &AFirst, const QList<ConditionStep> &ASteps, int AStep)
+{
+	const ConditionStep &step = ASteps.at(AStep);
+
+	Cursor elem = AFirst;
+	if (!elem.isNull() && !step.tagName.isEmpty() && elem.tagName()!=step.tagName)
+		elem = elem.nextSiblingElement(step.tagName);
+
+	while (!elem.isNull())
+	{
+		bool matched = true;
+		for (QList<ConditionAttribute>::const_iterator it=step.attributes.constBegin(); matched && it!=step.attributes.constEnd(); ++it)
+		{
+			QString value;
+			matched = elem.attributeValue(it->name,value) && (it->anyValue || it->values.contains(value));
+		}
+
+		if (matched && (AStep+1>=ASteps.count() || matchConditionStep(elem.firstChildElement(),ASteps,AStep+1)))
+			return true;
+
+		elem = elem.nextSiblingElement(step.tagName);
+	}
+
+	return false;
+}
+
+template<class Cursor>
+static QList<QString> childElementNamespaces(const Cursor &ARoot)
+{
+	QList<QString> namespaces;
+	for (Cursor child=ARoot.firstChildElement(); !child.isNull(); child=child.nextSiblingElement(QString::null))
+	{
+		QString ns;
+		if (child.attributeValue("xmlns",ns) && !namespaces.contains(ns))
+			namespaces.append(ns);
+	}
+	return namespaces;
+}
+
+static inline QString handleIndexKey(int ADirection, const QString &AKind, const QString &ANamespace)
+{
+	return QString::number(ADirection) + "|" + AKind + "|" + ANamespace;
+}
+
 StanzaProcessor::StanzaProcessor()
 {
 	FXmppStreamManager = NULL;
@@ -140,7 +251,14 @@ Stanza StanzaProcessor::makeReplyError(const Stanza &AStanza, const XmppStanzaEr
 
 bool StanzaProcessor::checkStanza(const Stanza &AStanza, const QString &ACondition) const
 {
-	return checkCondition(AStanza.element(),ACondition);
+	QHash<QString, StanzaCondition>::const_iterator it = FConditionCache.constFind(ACondition);
+	if (it == FConditionCache.constEnd())
+	{
+		if (FConditionCache.count() >= MAX_CONDITION_CACHE_SIZE)
+			FConditionCache.clear();
+		it = FConditionCache.insert(ACondition,compileCondition(ACondition));
+	}
+	return checkCondition(AStanza,it.value());
 }
 
 QList<int> StanzaProcessor::stanzaHandles() const
@@ -163,6 +281,8 @@ int StanzaProcessor::insertStanzaHandle(const IStanzaHandle &AHandle)
 
 		FHandles.insert(handleId,AHandle);
 		FHandleIdByOrder.insertMulti(AHandle.order,handleId);
+		insertHandleIndex(handleId);
+		updateHandlePositions();
 		connect(AHandle.handler->instance(),SIGNAL(destroyed(QObject *)),SLOT(onStanzaHandlerDestroyed(QObject *)));
 
 		LOG_DEBUG(QString("Stanza handle inserted, id=%1, handler=%2, order=%3, direction=%4, stream=%5, conditions=%6").arg(handleId).arg(AHandle.handler->instance()->metaObject()->className()).arg(AHandle.order).arg(AHandle.direction).arg(AHandle.streamJid.full()).arg(QStringList(AHandle.conditions).join("; ")));
@@ -182,125 +302,183 @@ void StanzaProcessor::removeStanzaHandle(int AHandleId)
 	if (FHandles.contains(AHandleId))
 	{
 		LOG_DEBUG(QString("Stanza handle removed, id=%1").arg(AHandleId));
+		removeHandleIndex(AHandleId);
 		IStanzaHandle shandle = FHandles.take(AHandleId);
 		FHandleIdByOrder.remove(shandle.order,AHandleId);
+		updateHandlePositions();
 		emit stanzaHandleRemoved(AHandleId,shandle);
 	}
 }
 
-bool StanzaProcessor::checkCondition(const QDomElement &AElem, const QString &ACondition, int APos) const
+StanzaCondition StanzaProcessor::compileCondition(const QString &ACondition) const
 {
 	static const QSet<QChar> delimiters = QSet<QChar>()<<' '<<'/'<<'\\'<<'\t'<<'\n'<<'['<<']'<<'='<<'\''<<'"'<<'@';
 
-	QDomElement elem = AElem;
+	StanzaCondition condition;
 
-	int pos = APos;
-	if (pos<ACondition.count() && ACondition[pos] == '/')
-		pos++;
-
-	QString tagName;
-	while (pos<ACondition.count() && !delimiters.contains(ACondition[pos]))
-		tagName.append(ACondition[pos++]);
+	int pos = 0;
+	do
+	{
+		ConditionStep step;
 
-	if (!tagName.isEmpty() &&  elem.tagName() != tagName)
-		elem = elem.nextSiblingElement(tagName);
+		if (pos<ACondition.count() && ACondition[pos] == '/')
+			pos++;
 
-	if (elem.isNull())
-		return false;
+		while (pos<ACondition.count() && !delimiters.contains(ACondition[pos]))
+			step.tagName.append(ACondition[pos++]);
 
-	QMultiHash<QString,QString> attributes;
-	while (pos<ACondition.count() && ACondition[pos] != '/')
-	{
-		if (ACondition[pos] == '[')
+		while (pos<ACondition.count() && ACondition[pos] != '/')
 		{
-			pos++;
-			QString attrName;
-			QString attrValue;
-			while (pos<ACondition.count() && ACondition[pos] != ']')
+			if (ACondition[pos] == '[')
 			{
-				if (ACondition[pos] == '@')
-				{
-					pos++;
-					while (pos<ACondition.count() && !delimiters.contains(ACondition[pos]))
-						attrName.append(ACondition[pos++]);
-				}
-				else if (ACondition[pos]=='"' || ACondition[pos]=='\'')
+				pos++;
+				QString attrName;
+				QString attrValue;
+				while (pos<ACondition.count() && ACondition[pos] != ']')
 				{
-					QChar end = ACondition[pos++];
-					while (pos<ACondition.count() && ACondition[pos]!=end)
-						attrValue.append(ACondition[pos++]);
-					pos++;
+					if (ACondition[pos] == '@')
+					{
+						pos++;
+						while (pos<ACondition.count() && !delimiters.contains(ACondition[pos]))
+							attrName.append(ACondition[pos++]);
+					}
+					else if (ACondition[pos]=='"' || ACondition[pos]=='\'')
+					{
+						QChar end = ACondition[pos++];
+						while (pos<ACondition.count() && ACondition[pos]!=end)
+							attrValue.append(ACondition[pos++]);
+						pos++;
+					}
+					else 
+					{
+						pos++;
+					}
 				}
-				else 
+
+				if (!attrName.isEmpty())
 				{
-					pos++;
+					int index = 0;
+					while (index<step.attributes.count() && step.attributes.at(index).name!=attrName)
+						index++;
+					if (index == step.attributes.count())
+					{
+						ConditionAttribute attr;
+						attr.name = attrName;
+						step.attributes.append(attr);
+					}
+
+					ConditionAttribute &attr = step.attributes[index];
+					attr.values.append(attrValue);
+					attr.anyValue = attr.anyValue || attrValue.isEmpty();
 				}
+				pos++;
+			}
+			else 
+			{
+				pos++;
 			}
-			if (!attrName.isEmpty())
-				attributes.insertMulti(attrName,attrValue);
-			pos++;
-		}
-		else 
-		{
-			pos++;
 		}
+
+		condition.steps.append(step);
+	} while (pos < ACondition.count());
+
+	condition.rootName = condition.steps.value(0).tagName;
+	foreach(const ConditionAttribute &attr, condition.steps.value(1).attributes)
+	{
+		if (attr.name=="xmlns" && !attr.anyValue)
+			condition.childNamespaces = attr.values;
 	}
 
-	if (pos < ACondition.count() && !elem.hasChildNodes())
-		return false;
+	return condition;
+}
 
-	while (!elem.isNull())
+bool StanzaProcessor::checkCondition(const Stanza &AStanza, const StanzaCondition &ACondition) const
+{
+	if (!AStanza.tree().isEmpty())
+		return matchConditionStep(TreeElementCursor(&AStanza.tree(),0),ACondition.steps,0);
+	return matchConditionStep(DomElementCursor(AStanza.element()),ACondition.steps,0);
+}
+
+QSet<QString> StanzaProcessor::stanzaIndexKeys(const Stanza &AStanza, int ADirection) const
+{
+	QString kind = AStanza.kind();
+	QList<QString> namespaces = !AStanza.tree().isEmpty() ? childElementNamespaces(TreeElementCursor(&AStanza.tree(),0)) : childElementNamespaces(DomElementCursor(AStanza.element()));
+
+	QSet<QString> keys;
+	keys += handleIndexKey(ADirection,kind,QString::null);
+	keys += handleIndexKey(ADirection,QString::null,QString::null);
+	foreach(const QString &ns, namespaces)
 	{
-		int attr = 0;
-		QList<QString> attrNames = attributes.keys();
-		while (attr<attrNames.count() && !elem.isNull())
+		keys += handleIndexKey(ADirection,kind,ns);
+		keys += handleIndexKey(ADirection,QString::null,ns);
+	}
+	return keys;
+}
+
+QMap<int, int> StanzaProcessor::indexedHandles(const QSet<QString> &AIndexKeys) const
+{
+	QMap<int, int> handles;
+	foreach(const QString &key, AIndexKeys)
+	{
+		QHash<QString, QList<int> >::const_iterator it = FHandleIndex.constFind(key);
+		if (it != FHandleIndex.constEnd())
 		{
-			QString attrName = attrNames.at(attr);
-			QList<QString> attrValues = attributes.values(attrName);
-			bool attrBlankValue = attrValues.contains(QString::null);
+			foreach(int handleId, it.value())
+				handles.insert(FHandlePositions.value(handleId),handleId);
+		}
+	}
+	return handles;
+}
 
-			bool elemHasAttr;
-			QString elemAttrValue;
-			if (elem.hasAttribute(attrName))
-			{
-				elemHasAttr = true;
-				elemAttrValue = elem.attribute(attrName);
-			}
-			else if (attrName == "xmlns")
-			{
-				elemHasAttr = true;
-				elemAttrValue = elem.namespaceURI();
-			}
-			else
-			{
-				elemHasAttr = false;
-			}
+void StanzaProcessor::insertHandleIndex(int AHandleId)
+{
+	const IStanzaHandle &shandle = FHandles[AHandleId];
+	QList<StanzaCondition> &conditions = FHandleConditions[AHandleId];
+	foreach(const QString &condString, shandle.conditions)
+	{
+		StanzaCondition condition = compileCondition(condString);
 
-			if (!elemHasAttr || (!attrValues.contains(elemAttrValue) && !attrBlankValue))
-			{
-				elem = elem.nextSiblingElement(tagName);
-				attr = 0;
-			}
-			else 
-			{
-				attr++;
-			}
+		QList<QString> keys;
+		if (!condition.childNamespaces.isEmpty())
+		{
+			foreach(const QString &ns, condition.childNamespaces)
+				keys.append(handleIndexKey(shandle.direction,condition.rootName,ns));
 		}
-
-		if (!elem.isNull() && pos<ACondition.count())
+		else
 		{
-			if (checkCondition(elem.firstChildElement(),ACondition,pos))
-				return true;
-			else
-				elem = elem.nextSiblingElement(tagName);
+			keys.append(handleIndexKey(shandle.direction,condition.rootName,QString::null));
 		}
-		else if (!elem.isNull())
+
+		foreach(const QString &key, keys)
 		{
-			return true;
+			QList<int> &handles = FHandleIndex[key];
+			if (!handles.contains(AHandleId))
+				handles.append(AHandleId);
 		}
+
+		conditions.append(condition);
+	}
+}
+
+void StanzaProcessor::removeHandleIndex(int AHandleId)
+{
+	for (QHash<QString, QList<int> >::iterator it=FHandleIndex.begin(); it!=FHandleIndex.end(); )
+	{
+		it->removeAll(AHandleId);
+		if (it->isEmpty())
+			it = FHandleIndex.erase(it);
+		else
+			++it;
 	}
+	FHandleConditions.remove(AHandleId);
+	FHandlePositions.remove(AHandleId);
+}
 
-	return false;
+void StanzaProcessor::updateHandlePositions()
+{
+	int position = 0;
+	for (QMultiMap<int, int>::const_iterator it=FHandleIdByOrder.constBegin(); it!=FHandleIdByOrder.constEnd(); ++it)
+		FHandlePositions.insert(it.value(),position++);
 }
 
 bool StanzaProcessor::processStanza(const Jid &AStreamJid, Stanza &AStanza, int ADirection) const
@@ -308,22 +486,42 @@ bool StanzaProcessor::processStanza(const Jid &AStreamJid, Stanza &AStanza, int
 	bool hooked = false;
 	bool accepted = false;
 
-	QMapIterator<int, int> it(FHandleIdByOrder);
-	while (!hooked && it.hasNext())
+	QSet<QString> indexKeys = stanzaIndexKeys(AStanza,ADirection);
+	QMap<int, int> handles = indexedHandles(indexKeys);
+
+	QMap<int, int>::const_iterator it = handles.constBegin();
+	while (!hooked && it!=handles.constEnd())
 	{
-		it.next();
-		const IStanzaHandle &shandle = FHandles.value(it.value());
-		if (shandle.direction==ADirection && (shandle.streamJid.isEmpty() || shandle.streamJid==AStreamJid))
+		int position = it.key();
+		int handleId = it.value();
+
+		bool processed = false;
+		const IStanzaHandle &shandle = FHandles.value(handleId);
+		if (shandle.streamJid.isEmpty() || shandle.streamJid==AStreamJid)
 		{
-			for (int i = 0; i<shandle.conditions.count(); i++)
+			foreach(const StanzaCondition &condition, FHandleConditions.value(handleId))
 			{
-				if (checkCondition(AStanza.element(), shandle.conditions.at(i)))
+				if (checkCondition(AStanza,condition))
 				{
-					hooked = shandle.handler->stanzaReadWrite(it.value(),AStreamJid,AStanza,accepted);
+					hooked = shandle.handler->stanzaReadWrite(handleId,AStreamJid,AStanza,accepted);
+					processed = true;
 					break;
 				}
 			}
 		}
+
+		QSet<QString> newKeys = processed && !hooked ? stanzaIndexKeys(AStanza,ADirection) : indexKeys;
+		if (newKeys != indexKeys)
+		{
+			// Handler has changed the stanza, select not yet processed handles again
+			indexKeys = newKeys;
+			handles = indexedHandles(indexKeys);
+			it = handles.upperBound(position);
+		}
+		else
+		{
+			++it;
+		}
 	}
 
 	return ADirection==IStanzaHandle::DirectionIn ? accepted : hooked;
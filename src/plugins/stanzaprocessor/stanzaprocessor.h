@@ -1,6 +1,8 @@
 #ifndef STANZAPROCESSOR_H
 #define STANZAPROCESSOR_H
 
+#include <QSet>
+#include <QHash>
 #include <QTimer>
 #include <QMultiMap>
 #include <QDomDocument>
@@ -19,6 +21,26 @@ struct StanzaRequest {
 	IStanzaRequestOwner *owner;
 };
 
+struct ConditionAttribute {
+	ConditionAttribute() {
+		anyValue = false;
+	}
+	bool anyValue;
+	QString name;
+	QList<QString> values;
+};
+
+struct ConditionStep {
+	QString tagName;
+	QList<ConditionAttribute> attributes;
+};
+
+struct StanzaCondition {
+	QString rootName;
+	QList<QString> childNamespaces;
+	QList<ConditionStep> steps;
+};
+
 class StanzaProcessor :
 	public QObject,
 	public IPlugin,
@@ -58,7 +80,13 @@ signals:
 	void stanzaHandleInserted(int AHandleId, const IStanzaHandle &AHandle);
 	void stanzaHandleRemoved(int AHandleId, const IStanzaHandle &AHandle);
 protected:
-	bool checkCondition(const QDomElement &AElem, const QString &ACondition, int APos = 0) const;
+	StanzaCondition compileCondition(const QString &ACondition) const;
+	bool checkCondition(const Stanza &AStanza, const StanzaCondition &ACondition) const;
+	QSet<QString> stanzaIndexKeys(const Stanza &AStanza, int ADirection) const;
+	QMap<int, int> indexedHandles(const QSet<QString> &AIndexKeys) const;
+	void insertHandleIndex(int AHandleId);
+	void removeHandleIndex(int AHandleId);
+	void updateHandlePositions();
 	bool processStanza(const Jid &AStreamJid, Stanza &AStanza, int ADirection) const;
 	bool processStanzaRequest(const Jid &AStreamJid, const Stanza &AStanza);
 	void processRequestTimeout(const QString &AStanzaId) const;
@@ -77,6 +105,10 @@ private:
 private:
 	QMap<int, IStanzaHandle> FHandles;
 	QMultiMap<int, int> FHandleIdByOrder;
+	QHash<int, int> FHandlePositions;
+	QHash<QString, QList<int> > FHandleIndex;
+	QMap<int, QList<StanzaCondition> > FHandleConditions;
+	mutable QHash<QString, StanzaCondition> FConditionCache;
 	QMap<QString, StanzaRequest> FRequests;
 };
 
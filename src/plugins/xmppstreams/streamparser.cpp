@@ -1,6 +1,5 @@
 #include "streamparser.h"
 
-#include <QMap>
 #include <definitions/namespaces.h>
 #include <utils/logger.h>
 
@@ -16,8 +15,6 @@ StreamParser::~StreamParser()
 
 void StreamParser::parseData(const QByteArray &AData)
 {
-	static QDomDocument doc;
-
 	FReader.addData(AData);
 	while (!FReader.atEnd())
 	{
@@ -25,71 +22,90 @@ void StreamParser::parseData(const QByteArray &AData)
 		if (FReader.isStartDocument())
 		{
 			FLevel = 0;
-			FStanzaElem = FCurrentElem = QDomElement();
+			FCurrentNode = -1;
+			FStanzaTree.clear();
 		}
 		else if (FReader.isStartElement())
 		{
-			QDomElement newElem = doc.createElementNS(FReader.namespaceUri().toString(),FReader.qualifiedName().toString());
-			
-			foreach(const QXmlStreamNamespaceDeclaration &ns, FReader.namespaceDeclarations())
+			FLevel++;
+			if (FLevel <= 2)
+				FStanzaTree.clear();
+
+			int newNode = FStanzaTree.appendElement(FLevel>2 ? FCurrentNode : -1,FReader.namespaceUri(),FReader.qualifiedName());
+
+			QXmlStreamNamespaceDeclarations nsDeclarations = FReader.namespaceDeclarations();
+			for (int i=0; i<nsDeclarations.count(); i++)
 			{
+				const QXmlStreamNamespaceDeclaration &ns = nsDeclarations.at(i);
 				if (ns.prefix() != FReader.prefix())
 				{
-					if (!ns.prefix().isEmpty())
-						newElem.setAttribute(QString("xmlns:%1").arg(ns.prefix().toString()), ns.namespaceUri().toString());
-					else
-						newElem.setAttribute(QString("xmlns"), ns.namespaceUri().toString());
+					QString nsAttr = !ns.prefix().isEmpty() ? QString("xmlns:%1").arg(ns.prefix().toString()) : QString("xmlns");
+					FStanzaTree.appendAttribute(newNode,QStringRef(),QStringRef(&nsAttr),ns.namespaceUri());
 				}
 			}
 
-			foreach(const QXmlStreamAttribute &attribute, FReader.attributes())
+			QXmlStreamAttributes attributes = FReader.attributes();
+			for (int i=0; i<attributes.count(); i++)
 			{
-				if (!attribute.namespaceUri().isEmpty())
-					newElem.setAttributeNS(attribute.namespaceUri().toString(),attribute.qualifiedName().toString(),attribute.value().toString());
-				else
-					newElem.setAttribute(attribute.qualifiedName().toString(),attribute.value().toString());
+				const QXmlStreamAttribute &attribute = attributes.at(i);
+				FStanzaTree.appendAttribute(newNode,attribute.namespaceUri(),attribute.qualifiedName(),attribute.value());
 			}
 
-			FLevel++;
 			if (FLevel == 1)
 			{
-				emit opened(newElem);
-			}
-			else if (FLevel == 2)
-			{
-				FStanzaElem = newElem;
-				FCurrentElem = FStanzaElem;
+				emit opened(Stanza(FStanzaTree));
+				FStanzaTree.clear();
+				FCurrentNode = -1;
 			}
 			else
 			{
-				FCurrentElem.appendChild(newElem);
-				FCurrentElem = newElem;
+				FCurrentNode = newNode;
 			}
 
-			FElemSpace = QDomText();
+			FElemSpace = QString::null;
 		}
 		else if (FReader.isCharacters())
 		{
-			if (FReader.isCDATA())
-				FCurrentElem.appendChild(doc.createCDATASection(FReader.text().toString()));
-			else if (FReader.isWhitespace())
-				FElemSpace = doc.createTextNode(FReader.text().toString());
-			else
-				FCurrentElem.appendChild(doc.createTextNode(FReader.text().toString()));
+			if (FLevel > 1)
+			{
+				if (FReader.isCDATA())
+				{
+					FStanzaTree.appendText(FCurrentNode,FReader.text(),true);
+				}
+				else if (FReader.isWhitespace())
+				{
+					FElemSpace = FReader.text().toString();
+				}
+				else
+				{
+					if (!FElemSpace.isNull())
+						FStanzaTree.appendText(FCurrentNode,QStringRef(&FElemSpace));
+					FStanzaTree.appendText(FCurrentNode,FReader.text());
+					FElemSpace = QString::null;
+				}
+			}
 		}
 		else if (FReader.isEndElement())
 		{
-			if (!FElemSpace.isNull() && !FCurrentElem.hasChildNodes())
-				FCurrentElem.appendChild(FElemSpace);
-			FElemSpace = QDomText();
+			if (!FElemSpace.isNull() && !FStanzaTree.hasChildNodes(FCurrentNode))
+				FStanzaTree.appendText(FCurrentNode,QStringRef(&FElemSpace));
+			FElemSpace = QString::null;
 
 			FLevel--;
 			if (FLevel > 1)
-				FCurrentElem = FCurrentElem.parentNode().toElement();
+			{
+				FCurrentNode = FStanzaTree.parentNode(FCurrentNode);
+			}
 			else if (FLevel == 1)
-				emit element(FStanzaElem);
+			{
+				emit element(Stanza(FStanzaTree));
+				FStanzaTree.clear();
+				FCurrentNode = -1;
+			}
 			else if (FLevel == 0)
+			{
 				emit closed();
+			}
 		}
 	}
 
@@ -102,6 +118,10 @@ void StreamParser::parseData(const QByteArray &AData)
 
 void StreamParser::restart()
 {
+	FLevel = 0;
+	FCurrentNode = -1;
+	FElemSpace = QString::null;
+	FStanzaTree.clear();
 	FReader.clear();
 	FReader.setNamespaceProcessing(true);
 }
@@ -1,8 +1,8 @@
 #ifndef STREAMPARSER_H
 #define STREAMPARSER_H
 
-#include <QDomDocument>
 #include <QXmlStreamReader>
+#include <utils/stanza.h>
 #include <utils/xmpperror.h>
 
 class StreamParser :
@@ -15,15 +15,15 @@ public:
 	void parseData(const QByteArray &AData);
 	void restart();
 signals:
-	void opened(const QDomElement &AElem);
-	void element(const QDomElement &AElem);
+	void opened(const Stanza &AStanza);
+	void element(const Stanza &AStanza);
 	void error(const XmppError &AError);
 	void closed();
 private:
 	int FLevel;
-	QDomText FElemSpace;
-	QDomElement FStanzaElem;
-	QDomElement FCurrentElem;
+	int FCurrentNode;
+	QString FElemSpace;
+	StanzaTree FStanzaTree;
 	QXmlStreamReader FReader;
 };
 
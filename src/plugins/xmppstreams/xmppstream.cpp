@@ -22,16 +22,24 @@ XmppStream::XmppStream(IXmppStreamManager *AXmppStreamManager, const Jid &AStrea
 	FConnection = NULL;
 	FStreamState = SS_OFFLINE;
 
+	FCorkCount = 0;
+	FBatchMaxSize = 0;
+	FBatchMaxLatency = 0;
+	FBatchEnabled = false;
+
 	FStreamJid = AStreamJid;
 	FOfflineJid = FStreamJid;
 
-	connect(&FParser,SIGNAL(opened(const QDomElement &)), SLOT(onParserOpened(const QDomElement &)));
-	connect(&FParser,SIGNAL(element(const QDomElement &)), SLOT(onParserElement(const QDomElement &)));
+	connect(&FParser,SIGNAL(opened(const Stanza &)), SLOT(onParserOpened(const Stanza &)));
+	connect(&FParser,SIGNAL(element(const Stanza &)), SLOT(onParserElement(const Stanza &)));
 	connect(&FParser,SIGNAL(error(const XmppError &)), SLOT(onParserError(const XmppError &)));
 	connect(&FParser,SIGNAL(closed()), SLOT(onParserClosed()));
 
 	FKeepAliveTimer.setSingleShot(false);
 	connect(&FKeepAliveTimer,SIGNAL(timeout()),SLOT(onKeepAliveTimeout()));
+
+	FFlushTimer.setSingleShot(true);
+	connect(&FFlushTimer,SIGNAL(timeout()),SLOT(onFlushTimerTimeout()));
 }
 
 XmppStream::~XmppStream()
@@ -96,6 +104,10 @@ bool XmppStream::open()
 		FError = XmppError::null;
 
 		LOG_STRM_INFO(streamJid(),"Opening XMPP stream");
+
+		FBatchEnabled = Options::node(OPV_XMPPSTREAMS_BATCHING_ENABLED).value().toBool();
+		FBatchMaxSize = Options::node(OPV_XMPPSTREAMS_BATCHING_MAXSIZE).value().toInt();
+		FBatchMaxLatency = Options::node(OPV_XMPPSTREAMS_BATCHING_MAXLATENCY).value().toInt();
 		if (FConnection->connectToHost())
 		{
 			FNodeChanged = false;
@@ -362,6 +374,9 @@ qint64 XmppStream::sendStanza(Stanza &AStanza)
 					AStanza.setTo(newToJid.full());
 				}
 			}
+			// Stanzas are batched only in online state to keep stream negotiation strictly ordered
+			if (FStreamState==SS_ONLINE && (FBatchEnabled || FCorkCount>0))
+				return queueData(AStanza.toByteArray());
 			return sendData(AStanza.toByteArray());
 		}
 		else if (FClosed)
@@ -376,10 +391,42 @@ qint64 XmppStream::sendStanza(Stanza &AStanza)
 	return -1;
 }
 
+bool XmppStream::isCorked() const
+{
+	return FCorkCount > 0;
+}
+
+void XmppStream::cork()
+{
+	FCorkCount++;
+}
+
+void XmppStream::uncork()
+{
+	if (FCorkCount > 0)
+	{
+		FCorkCount--;
+		if (FCorkCount == 0)
+			flush();
+	}
+}
+
+void XmppStream::flush()
+{
+	FFlushTimer.stop();
+	if (!FOutBuffer.isEmpty())
+	{
+		QByteArray data = FOutBuffer;
+		FOutBuffer.clear();
+		writeData(data);
+	}
+}
+
 void XmppStream::insertXmppDataHandler(int AOrder, IXmppDataHandler *AHandler)
 {
 	if (AHandler && !FDataHandlers.contains(AOrder, AHandler))
 	{
+		flush();
 		LOG_STRM_DEBUG(streamJid(),QString("XMPP data handler inserted, order=%1, address=%2").arg(AOrder).arg((quint64)AHandler));
 		FDataHandlers.insertMulti(AOrder, AHandler);
 		emit dataHandlerInserted(AOrder,AHandler);
@@ -390,6 +437,7 @@ void XmppStream::removeXmppDataHandler(int AOrder, IXmppDataHandler *AHandler)
 {
 	if (FDataHandlers.contains(AOrder, AHandler))
 	{
+		flush();
 		LOG_STRM_DEBUG(streamJid(),QString("XMPP data handler removed, order=%1, address=%2").arg(AOrder).arg((quint64)AHandler));
 		FDataHandlers.remove(AOrder, AHandler);
 		emit dataHandlerRemoved(AOrder,AHandler);
@@ -528,7 +576,9 @@ bool XmppStream::processDataHandlers(QByteArray &AData, bool ADataOut)
 
 bool XmppStream::processStanzaHandlers(Stanza &AStanza, bool AStanzaOut)
 {
-	if (!AStanzaOut)
+	// Do not serialize stanza when it will not be logged, it forces DOM materialization
+	bool logStanza = (Logger::enabledTypes() & Logger::Stanza)>0;
+	if (!AStanzaOut && logStanza)
 		LOG_STRM_TYPE(Logger::Stanza,streamJid(),QString("Stanza received:\n\n%1").arg(AStanza.toString(2)));
 
 	bool hooked = false;
@@ -552,13 +602,19 @@ bool XmppStream::processStanzaHandlers(Stanza &AStanza, bool AStanzaOut)
 		}
 	}
 
-	if (AStanzaOut && !hooked)
+	if (AStanzaOut && !hooked && logStanza)
 		LOG_STRM_TYPE(Logger::Stanza,streamJid(),QString("Stanza sent:\n\n%1").arg(AStanza.toString(2)));
 
 	return hooked;
 }
 
 qint64 XmppStream::sendData(QByteArray AData)
+{
+	flush();
+	return writeData(AData);
+}
+
+qint64 XmppStream::writeData(QByteArray AData)
 {
 	if (!processDataHandlers(AData,true))
 	{
@@ -568,6 +624,23 @@ qint64 XmppStream::sendData(QByteArray AData)
 	return 0;
 }
 
+qint64 XmppStream::queueData(const QByteArray &AData)
+{
+	FOutBuffer.append(AData);
+	if (FOutBuffer.size() >= FBatchMaxSize)
+		flush();
+	else if (!FFlushTimer.isActive())
+		FFlushTimer.start(FCorkCount>0 ? FBatchMaxLatency : 0);
+	return AData.size();
+}
+
+void XmppStream::clearOutBuffer()
+{
+	FCorkCount = 0;
+	FFlushTimer.stop();
+	FOutBuffer.clear();
+}
+
 QByteArray XmppStream::receiveData(qint64 ABytes)
 {
 	return FConnection->read(ABytes);
@@ -611,6 +684,7 @@ void XmppStream::onConnectionDisconnected()
 
 		setStreamState(SS_OFFLINE);
 		setKeepAliveTimerActive(false);
+		clearOutBuffer();
 		removeXmppStanzaHandler(XSHO_XMPP_STREAM,this);
 
 		LOG_STRM_INFO(streamJid(),"XMPP stream closed");
@@ -626,15 +700,15 @@ void XmppStream::onConnectionDisconnected()
 	}
 }
 
-void XmppStream::onParserOpened(const QDomElement &AElem)
+void XmppStream::onParserOpened(const Stanza &AStanza)
 {
-	Stanza stanza(AElem);
+	Stanza stanza(AStanza);
 	processStanzaHandlers(stanza,false);
 }
 
-void XmppStream::onParserElement(const QDomElement &AElem)
+void XmppStream::onParserElement(const Stanza &AStanza)
 {
-	Stanza stanza(AElem);
+	Stanza stanza(AStanza);
 	processStanzaHandlers(stanza,false);
 }
 
@@ -677,6 +751,11 @@ void XmppStream::onFeatureDestroyed()
 		FActiveFeatures.removeAll(feature);
 }
 
+void XmppStream::onFlushTimerTimeout()
+{
+	flush();
+}
+
 void XmppStream::onKeepAliveTimeout()
 {
 	static const QByteArray space(1,' ');
@@ -54,6 +54,10 @@ public:
 	virtual bool isKeepAliveTimerActive() const;
 	virtual void setKeepAliveTimerActive(bool AActive);
 	virtual qint64 sendStanza(Stanza &AStanza);
+	virtual bool isCorked() const;
+	virtual void cork();
+	virtual void uncork();
+	virtual void flush();
 	virtual void insertXmppDataHandler(int AOrder, IXmppDataHandler *AHandler);
 	virtual void removeXmppDataHandler(int AOrder, IXmppDataHandler *AHandler);
 	virtual void insertXmppStanzaHandler(int AOrder, IXmppStanzaHadler *AHandler);
@@ -82,6 +86,9 @@ protected:
 	bool processDataHandlers(QByteArray &AData, bool ADataOut);
 	bool processStanzaHandlers(Stanza &AStanza, bool AStanzaOut);
 	qint64 sendData(QByteArray AData);
+	qint64 writeData(QByteArray AData);
+	qint64 queueData(const QByteArray &AData);
+	void clearOutBuffer();
 	QByteArray receiveData(qint64 ABytes);
 protected slots:
 	//IStreamConnection
@@ -90,8 +97,8 @@ protected slots:
 	void onConnectionError(const XmppError &AError);
 	void onConnectionDisconnected();
 	//StreamParser
-	void onParserOpened(const QDomElement &AElem);
-	void onParserElement(const QDomElement &AElem);
+	void onParserOpened(const Stanza &AStanza);
+	void onParserElement(const Stanza &AStanza);
 	void onParserError(const XmppError &AError);
 	void onParserClosed();
 	//IXmppFeature
@@ -100,6 +107,8 @@ protected slots:
 	void onFeatureDestroyed();
 	//KeepAlive
 	void onKeepAliveTimeout();
+	//Batching
+	void onFlushTimerTimeout();
 private:
 	IConnection *FConnection;
 	IXmppStreamManager *FXmppStreamManager;
@@ -124,6 +133,13 @@ private:
 	QDomElement FServerFeatures;
 	QList<QString>	FAvailFeatures;
 	QList<IXmppFeature *> FActiveFeatures;
+private:
+	int FCorkCount;
+	int FBatchMaxSize;
+	int FBatchMaxLatency;
+	bool FBatchEnabled;
+	QTimer FFlushTimer;
+	QByteArray FOutBuffer;
 private:
 	QMultiMap<int, IXmppDataHandler *> FDataHandlers;
 	QMultiMap<int, IXmppStanzaHadler *> FStanzaHandlers;
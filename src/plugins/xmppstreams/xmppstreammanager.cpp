@@ -43,6 +43,9 @@ bool XmppStreamManager::initSettings()
 	Options::setDefaultValue(OPV_XMPPSTREAMS_TIMEOUT_HANDSHAKE,60000);
 	Options::setDefaultValue(OPV_XMPPSTREAMS_TIMEOUT_KEEPALIVE,30000);
 	Options::setDefaultValue(OPV_XMPPSTREAMS_TIMEOUT_DISCONNECT,5000);
+	Options::setDefaultValue(OPV_XMPPSTREAMS_BATCHING_ENABLED,true);
+	Options::setDefaultValue(OPV_XMPPSTREAMS_BATCHING_MAXLATENCY,100);
+	Options::setDefaultValue(OPV_XMPPSTREAMS_BATCHING_MAXSIZE,65536);
 	return true;
 }
 
@@ -56,11 +56,21 @@ QVariant AdvancedItem::data(int ARole) const
 		const AdvancedItemModel *advModel = qobject_cast<AdvancedItemModel *>(model());
 		if (advModel)
 		{
+			QHash<int, QVariant> &cache = advModel->FItemDataCache[this];
+			QHash<int, QVariant>::const_iterator cacheIt = cache.constFind(ARole);
+			if (cacheIt != cache.constEnd())
+				return cacheIt.value();
+
 			const QMultiMap<int, AdvancedItemDataHolder *> holders = advModel->itemDataHolders(ARole);
 			for(QMultiMap<int, AdvancedItemDataHolder *>::const_iterator it=holders.constBegin(); value.isNull() && it!=holders.constEnd(); ++it)
 				value = it.value()->advancedItemData(it.key(),this,ARole);
+
+			if (value.isNull())
+				value = FData.value(ARole);
+			advModel->FItemDataCache[this].insert(ARole,value);
+			return value;
 		}
-		return value.isNull() ? FData.value(ARole) : value;
+		return FData.value(ARole);
 	}
 	return value;
 }
@@ -186,6 +186,7 @@ void AdvancedItemModel::insertItemDataHolder(int AOrder, AdvancedItemDataHolder
 			if (role != AnyRole)
 				FItemDataHolders[role].insertMulti(AOrder,AHolder);
 		FItemDataHolders[AnyRole].insertMulti(AOrder,AHolder);
+		FItemDataCache.clear();
 	}
 }
 
@@ -197,6 +198,7 @@ void AdvancedItemModel::removeItemDataHolder(int AOrder, AdvancedItemDataHolder
 			if (role != AnyRole)
 				FItemDataHolders[role].remove(AOrder,AHolder);
 		FItemDataHolders[AnyRole].remove(AOrder,AHolder);
+		FItemDataCache.clear();
 	}
 }
 
@@ -268,6 +270,7 @@ void AdvancedItemModel::emitItemChanged(QStandardItem *AItem)
 
 void AdvancedItemModel::emitItemDataChanged(QStandardItem *AItem, int ARole)
 {
+	clearItemDataCache(AItem);
 	if (!FDelayedDataChangedSignals)
 	{
 		if (ARole >= FIRST_VALID_ROLE)
@@ -295,6 +298,13 @@ void AdvancedItemModel::emitRecursiveParentDataChanged(QStandardItem *AParent)
 	}
 }
 
+void AdvancedItemModel::clearItemDataCache(QStandardItem *AItem)
+{
+	// Parent items data is often calculated from their children
+	for (QStandardItem *item=AItem; item!=NULL; item=item->parent())
+		FItemDataCache.remove(item);
+}
+
 void AdvancedItemModel::onEmitDelayedDataChangedSignals()
 {
 	QStandardItem *lastItem = NULL;
@@ -311,6 +321,7 @@ void AdvancedItemModel::onEmitDelayedDataChangedSignals()
 
 void AdvancedItemModel::onRowsInserted(const QModelIndex &AParent, int AStart, int AEnd)
 {
+	FItemDataCache.clear();
 	int colums = columnCount(AParent);
 	for (int row=AStart; row<=AEnd; row++)
 		for (int col=0; col<colums; col++)
@@ -320,6 +331,7 @@ void AdvancedItemModel::onRowsInserted(const QModelIndex &AParent, int AStart, i
 
 void AdvancedItemModel::onColumnsInserted(const QModelIndex &AParent, int AStart, int AEnd)
 {
+	FItemDataCache.clear();
 	int rows = rowCount(AParent);
 	for (int col=AStart; col<=AEnd; col++)
 		for(int row=0; row<rows; row++)
@@ -346,6 +358,7 @@ void AdvancedItemModel::onColumnsAboutToBeRemoved(const QModelIndex &AParent, in
 void AdvancedItemModel::onRowsOrColumnsRemoved(const QModelIndex &AParent, int AStart, int AEnd)
 {
 	Q_UNUSED(AStart); Q_UNUSED(AEnd);
+	FItemDataCache.clear();
 	for (QList<QPair<QStandardItem *, int> >::iterator it=FChangedItems.begin(); it!=FChangedItems.end(); )
 	{
 		if (FRemovingItems.contains(it->first))
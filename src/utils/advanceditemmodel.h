@@ -2,6 +2,7 @@
 #define ADVANCEDITEMMODEL_H
 
 #include <QPair>
+#include <QHash>
 #include <QStandardItemModel>
 #include "advanceditem.h"
 #include "utilsexport.h"
@@ -74,6 +75,8 @@ protected:
 	void emitItemChanged(QStandardItem *AItem);
 	void emitItemDataChanged(QStandardItem *AItem, int ARole);
 	void emitRecursiveParentDataChanged(QStandardItem *AParent);
+protected:
+	void clearItemDataCache(QStandardItem *AItem);
 protected slots:
 	void onEmitDelayedDataChangedSignals();
 	void onRowsInserted(const QModelIndex &AParent, int AStart, int AEnd);
@@ -88,6 +91,7 @@ private:
 	QList<QPair<QStandardItem *, int> > FChangedItems;
 	QMultiMap<int, AdvancedItemSortHandler *> FItemSortHandlers;
 	QMap<int, QMultiMap<int, AdvancedItemDataHolder *> > FItemDataHolders;
+	mutable QHash<const QStandardItem *, QHash<int, QVariant> > FItemDataCache;
 };
 
 #endif // ADVANCEDITEMMODEL_H
@@ -1,10 +1,15 @@
 #include "iconstorage.h"
 
 #include <QFile>
+#include <QEvent>
 #include <QImage>
+#include <QWidget>
 #include <QVariant>
+#include <QImageReader>
 #include <QApplication>
 
+#define MIN_ANIMATE_DELAY   20
+
 QHash<QString, IconStorage*> IconStorage::FStaticStorages;
 QHash<QObject*, IconStorage*> IconStorage::FObjectStorage;
 QHash<QString, QHash<QString,QIcon> > IconStorage::FIconCache;
@@ -15,41 +20,46 @@ struct IconStorage::IconAnimateFrame {
 	QIcon icon;
 };
 
+// Animation is shared by all objects displaying the same animated icon
 struct IconStorage::IconAnimateParams {
 	IconAnimateParams() { 
 		frameIndex = 0;
 		frameCount = 0;
-		timer = new QTimer;
-		reader = NULL;
+		interval = 0;
+		nextFrameTime = 0;
 	}
-	~IconAnimateParams() { 
-		timer->stop();
-		timer->deleteLater();
-		delete reader; 
+	int frameDelay() const {
+		return qMax(frames.isEmpty() ? interval : frames.at(frameIndex).delay, MIN_ANIMATE_DELAY);
 	}
+	QString key;
 	int frameIndex;
 	int frameCount;
-	QTimer *timer;
-	QImageReader *reader;
+	int interval;
+	qint64 nextFrameTime;
+	QList<QObject *> objects;
 	QList<IconAnimateFrame> frames;
 };
 
 struct IconStorage::IconUpdateParams {
 	IconUpdateParams() { 
+		paused = false;
 		animation = NULL; 
 	}
-	~IconUpdateParams() { 
-		delete animation; 
-	}
 	QString key;
 	int index;
 	int animate;
+	bool paused;
 	QString prop;
 	IconAnimateParams *animation;
 };
 
 IconStorage::IconStorage(const QString &AStorage, const QString &ASubStorage, QObject *AParent) : FileStorage(AStorage,ASubStorage,AParent)
 {
+	FAnimateClock.start();
+
+	FAnimateTimer.setSingleShot(true);
+	connect(&FAnimateTimer,SIGNAL(timeout()),SLOT(onAnimateTimer()));
+
 	connect(this,SIGNAL(storageChanged()),SLOT(onStorageChanged()));
 }
 
@@ -139,104 +149,137 @@ void IconStorage::initAnimation(QObject *AObject, IconUpdateParams *AParams)
 {
 	static const QList<QString> movieMimes = QList<QString>() << "image/gif" << "image/mng";
 
-	removeAnimation(AParams);
+	removeAnimation(AObject,AParams);
 	if (AParams->animate >= 0)
 	{
+		QString animKey;
+		int interval = 0;
 		int iconCount = filesCount(AParams->key);
 		QString file = fileFullName(AParams->key,AParams->index);
 		if (iconCount > 1)
 		{
-			int interval = AParams->animate > 0 ? AParams->animate : fileProperty(AParams->key,ICON_STORAGE_ANIMATE_INTERVAL).toInt();
+			interval = AParams->animate > 0 ? AParams->animate : fileProperty(AParams->key,ICON_STORAGE_ANIMATE_INTERVAL).toInt();
 			if (interval > 0)
-			{
-				AParams->animation = new IconAnimateParams;
-				AParams->animation->frameIndex = 0;
-				AParams->animation->frameCount = iconCount;
-				AParams->animation->timer->setSingleShot(false);
-				AParams->animation->timer->setInterval(interval);
-			}
+				animKey = QString("%1|%2|%3|%4").arg(storage(),subStorage(),AParams->key).arg(interval);
 		}
 		else if (!file.isEmpty() && movieMimes.contains(fileMime(AParams->key,AParams->index)))
 		{
-			AParams->animation = new IconAnimateParams;
-			QString key = fileCacheKey(AParams->key,AParams->index);
-			AParams->animation->frames = FAnimateCache[storage()].value(key);
-			if (!AParams->animation->frames.isEmpty())
-				AParams->animation->frameCount = AParams->animation->frames.count();
-			else
-				AParams->animation->reader = new QImageReader(file);
-			AParams->animation->timer->setSingleShot(true);
+			animKey = fileCacheKey(AParams->key,AParams->index);
 		}
-		if (AParams->animation)
+
+		if (!animKey.isEmpty())
 		{
-			AParams->animation->timer->start(0);
-			FTimerObject.insert(AParams->animation->timer,AObject);
-			connect(AParams->animation->timer,SIGNAL(timeout()),SLOT(onAnimateTimer()));
+			IconAnimateParams *animation = FAnimations.value(animKey);
+			if (animation == NULL)
+			{
+				animation = new IconAnimateParams;
+				animation->key = animKey;
+				if (interval > 0)
+				{
+					animation->interval = interval;
+					animation->frameCount = iconCount;
+				}
+				else
+				{
+					// Movie frames are decoded only once and then taken from cache
+					animation->frames = FAnimateCache[storage()].value(animKey);
+					if (animation->frames.isEmpty())
+					{
+						QImageReader reader(file);
+						while (reader.canRead())
+						{
+							QImage image = reader.read();
+							if (image.isNull())
+								break;
+
+							IconAnimateFrame frame;
+							frame.icon.addPixmap(QPixmap::fromImage(image));
+							frame.delay = reader.nextImageDelay();
+							animation->frames.append(frame);
+						}
+						FAnimateCache[storage()].insert(animKey,animation->frames);
+					}
+					animation->frameCount = animation->frames.count();
+				}
+
+				if (animation->frameCount > 1)
+				{
+					animation->nextFrameTime = FAnimateClock.elapsed() + animation->frameDelay();
+					FAnimations.insert(animKey,animation);
+				}
+				else
+				{
+					delete animation;
+					animation = NULL;
+				}
+			}
+
+			if (animation != NULL)
+			{
+				QWidget *widget = qobject_cast<QWidget *>(AObject);
+				if (widget != NULL)
+				{
+					AParams->paused = !widget->isVisible();
+					widget->installEventFilter(this);
+				}
+				AParams->animation = animation;
+				animation->objects.append(AObject);
+				startAnimateTimer();
+			}
 		}
 	}
 }
 
-void IconStorage::removeAnimation(IconUpdateParams *AParams)
+void IconStorage::removeAnimation(QObject *AObject, IconUpdateParams *AParams)
 {
 	if (AParams && AParams->animation)
 	{
-		FTimerObject.remove(AParams->animation->timer);
-		delete AParams->animation;
+		IconAnimateParams *animation = AParams->animation;
+		animation->objects.removeAll(AObject);
+		if (animation->objects.isEmpty())
+		{
+			FAnimations.remove(animation->key);
+			delete animation;
+		}
+		AObject->removeEventFilter(this);
+		AParams->paused = false;
 		AParams->animation = NULL;
 	}
 }
 
-void IconStorage::updateObject(QObject *AObject)
+void IconStorage::startAnimateTimer()
 {
-	QIcon icon;
-	IconUpdateParams *params = FUpdateParams[AObject];
-
-	if (params->animation!=NULL && params->animation->reader!=NULL)
+	qint64 nextFrameTime = -1;
+	foreach(IconAnimateParams *animation, FAnimations)
 	{
-		if (params->animation->reader->canRead())
+		foreach(QObject *object, animation->objects)
 		{
-			QImage image = params->animation->reader->read();
-			if (!image.isNull())
+			if (!FUpdateParams.value(object)->paused)
 			{
-				icon.addPixmap(QPixmap::fromImage(image));
-
-				IconAnimateFrame frame;
-				frame.icon = icon;
-				frame.delay = params->animation->reader->nextImageDelay();
-				params->animation->frames.append(frame);
-				
-				params->animation->frameCount = params->animation->frames.count();
-				params->animation->frameIndex = params->animation->frameCount-1;
+				if (nextFrameTime<0 || animation->nextFrameTime<nextFrameTime)
+					nextFrameTime = animation->nextFrameTime;
+				break;
 			}
-			else
-			{
-				removeAnimation(params);
-			}
-		}
-		else
-		{
-			QString key = fileCacheKey(params->key,params->index);
-			if (!key.isEmpty())
-				FAnimateCache[storage()].insert(key,params->animation->frames);
-
-			delete params->animation->reader;
-			params->animation->reader = NULL;
-			params->animation->frameIndex = 0;
 		}
 	}
 
+	if (nextFrameTime >= 0)
+		FAnimateTimer.start(qMax(nextFrameTime-FAnimateClock.elapsed(),(qint64)0));
+	else
+		FAnimateTimer.stop();
+}
+
+void IconStorage::updateObject(QObject *AObject)
+{
+	QIcon icon;
+	IconUpdateParams *params = FUpdateParams[AObject];
+
 	if (params->animation)
 	{
 		if (!params->animation->frames.isEmpty())
-		{
-			const IconAnimateFrame &frame = params->animation->frames.at(params->animation->frameIndex);
-			icon = frame.icon;
-			params->animation->timer->start(frame.delay);
-		}
+			icon = params->animation->frames.at(params->animation->frameIndex).icon;
 		else
-		{
 			icon = getIcon(params->key,params->animation->frameIndex);
-		}
 	}
 	else
 	{
@@ -253,30 +296,72 @@ void IconStorage::removeObject(QObject *AObject)
 {
 	FObjectStorage.remove(AObject);
 	IconUpdateParams *params = FUpdateParams.take(AObject);
-	removeAnimation(params);
+	removeAnimation(AObject,params);
 	delete params;
 }
 
+bool IconStorage::eventFilter(QObject *AObject, QEvent *AEvent)
+{
+	if (AEvent->type()==QEvent::Show || AEvent->type()==QEvent::Hide)
+	{
+		IconUpdateParams *params = FUpdateParams.value(AObject);
+		if (params!=NULL && params->animation!=NULL)
+		{
+			bool paused = AEvent->type()==QEvent::Hide;
+			if (params->paused != paused)
+			{
+				params->paused = paused;
+				if (!paused)
+					updateObject(AObject);
+				startAnimateTimer();
+			}
+		}
+	}
+	return FileStorage::eventFilter(AObject,AEvent);
+}
+
 void IconStorage::onStorageChanged()
 {
-	FTimerObject.clear();
+	// Animations of previous storage should not be shared with new ones
+	for (QHash<QObject*,IconUpdateParams*>::iterator it=FUpdateParams.begin(); it!=FUpdateParams.end(); ++it)
+		removeAnimation(it.key(),it.value());
+	qDeleteAll(FAnimations);
+	FAnimations.clear();
+
 	for (QHash<QObject*,IconUpdateParams*>::iterator it=FUpdateParams.begin(); it!=FUpdateParams.end(); ++it)
 	{
 		initAnimation(it.key(),it.value());
 		updateObject(it.key());
 	}
+	startAnimateTimer();
 }
 
 void IconStorage::onAnimateTimer()
 {
-	QObject *object = FTimerObject.value(qobject_cast<QTimer *>(sender()));
-	IconUpdateParams *params = FUpdateParams.value(object);
-	if (params)
+	qint64 curTime = FAnimateClock.elapsed();
+	foreach(const QString &animKey, FAnimations.keys())
 	{
-		if (!params->animation->reader)
-			params->animation->frameIndex = params->animation->frameCount>0 ? (params->animation->frameIndex + 1) % params->animation->frameCount : 0;
-		updateObject(object);
+		IconAnimateParams *animation = FAnimations.value(animKey);
+		if (animation!=NULL && animation->nextFrameTime<=curTime)
+		{
+			bool updated = false;
+			foreach(QObject *object, animation->objects)
+			{
+				IconUpdateParams *params = FUpdateParams.value(object);
+				if (params!=NULL && params->animation==animation && !params->paused)
+				{
+					if (!updated)
+					{
+						animation->frameIndex = (animation->frameIndex + 1) % animation->frameCount;
+						animation->nextFrameTime = curTime + animation->frameDelay();
+						updated = true;
+					}
+					updateObject(object);
+				}
+			}
+		}
 	}
+	startAnimateTimer();
 }
 
 void IconStorage::onObjectDestroyed(QObject *AObject)
@@ -4,6 +4,7 @@
 #include <QPair>
 #include <QIcon>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QImageReader>
 #include "filestorage.h"
 
@@ -27,16 +28,21 @@ public:
 	static IconStorage *staticStorage(const QString &AStorage);
 protected:
 	void initAnimation(QObject *AObject, IconUpdateParams *AParams);
-	void removeAnimation(IconUpdateParams *AParams);
+	void removeAnimation(QObject *AObject, IconUpdateParams *AParams);
+	void startAnimateTimer();
 	void updateObject(QObject *AObject);
 	void removeObject(QObject *AObject);
+protected:
+	bool eventFilter(QObject *AObject, QEvent *AEvent);
 protected slots:
 	void onStorageChanged();
 	void onAnimateTimer();
 	void onObjectDestroyed(QObject *AObject);
 private:
-	QHash<QTimer *, QObject *> FTimerObject;
+	QTimer FAnimateTimer;
+	QElapsedTimer FAnimateClock;
 	QHash<QObject *, IconUpdateParams *> FUpdateParams;
+	QHash<QString, IconAnimateParams *> FAnimations;
 private:
 	static QHash<QString, IconStorage *> FStaticStorages;
 	static QHash<QObject *, IconStorage *> FObjectStorage;
@@ -1,5 +1,8 @@
 #include "jid.h"
 
+#include <QMutex>
+#include <QMutexLocker>
+
 #ifdef USE_SYSTEM_IDN
 #	include <stringprep.h>
 #else
@@ -11,7 +14,52 @@ static const QChar CharSlash = '/';
 static const QList<QChar> EscChars =     QList<QChar>()   << 0x5c << 0x20 << 0x22 << 0x26 << 0x27 << 0x2f << 0x3a << 0x3c << 0x3e << 0x40;
 static const QList<QString> EscStrings = QList<QString>() <<"\\5c"<<"\\20"<<"\\22"<<"\\26"<<"\\27"<<"\\2f"<<"\\3a"<<"\\3c"<<"\\3e"<<"\\40";
 
-QHash<QString,Jid> Jid::FJidCache;
+#define JID_CACHE_SHARDS        16
+#define JID_CACHE_MAX_SIZE      32768
+
+// Jids are cached in two generations, entries not used during the last generation are dropped
+struct JidCacheShard {
+	JidCacheShard() {
+		hits = 0;
+		misses = 0;
+	}
+	bool lookup(const QString &AJidStr, Jid &AJid) {
+		QHash<QString,Jid>::const_iterator it = recent.constFind(AJidStr);
+		if (it == recent.constEnd())
+		{
+			it = old.constFind(AJidStr);
+			if (it == old.constEnd())
+			{
+				misses++;
+				return false;
+			}
+			AJid = it.value();
+			old.remove(AJidStr);
+			insert(AJidStr,AJid);
+		}
+		else
+		{
+			AJid = it.value();
+		}
+		hits++;
+		return true;
+	}
+	void insert(const QString &AJidStr, const Jid &AJid) {
+		if (recent.size() >= JID_CACHE_MAX_SIZE/JID_CACHE_SHARDS/2)
+		{
+			old = recent;
+			recent.clear();
+		}
+		recent.insert(AJidStr,AJid);
+	}
+	QMutex mutex;
+	quint64 hits;
+	quint64 misses;
+	QHash<QString,Jid> recent;
+	QHash<QString,Jid> old;
+};
+
+static JidCacheShard JidCache[JID_CACHE_SHARDS];
 const Jid Jid::null;
 
 static bool JidStreamOperatorsRegistered = false;
@@ -41,6 +89,7 @@ JidData::JidData()
 	FNodeValid = true;
 	FDomainValid = false;
 	FResourceValid = true;
+	FHash = 0;
 }
 
 JidData::JidData(const JidData &AOther) : QSharedData(AOther)
@@ -63,6 +112,8 @@ JidData::JidData(const JidData &AOther) : QSharedData(AOther)
 	FNodeValid = AOther.FNodeValid;
 	FDomainValid = AOther.FDomainValid;
 	FResourceValid = AOther.FResourceValid;
+
+	FHash = AOther.FHash;
 }
 
 Jid::Jid(const char *AJidStr)
@@ -396,10 +447,49 @@ QString Jid::resourcePrepare(const QString &AResource)
 	return stringPrepare(stringprep_xmpp_resourceprep, AResource);
 }
 
+int Jid::cacheSize()
+{
+	int size = 0;
+	for (int i=0; i<JID_CACHE_SHARDS; i++)
+	{
+		QMutexLocker locker(&JidCache[i].mutex);
+		size += JidCache[i].recent.size() + JidCache[i].old.size();
+	}
+	return size;
+}
+
+quint64 Jid::cacheHits()
+{
+	quint64 hits = 0;
+	for (int i=0; i<JID_CACHE_SHARDS; i++)
+	{
+		QMutexLocker locker(&JidCache[i].mutex);
+		hits += JidCache[i].hits;
+	}
+	return hits;
+}
+
+quint64 Jid::cacheMisses()
+{
+	quint64 misses = 0;
+	for (int i=0; i<JID_CACHE_SHARDS; i++)
+	{
+		QMutexLocker locker(&JidCache[i].mutex);
+		misses += JidCache[i].misses;
+	}
+	return misses;
+}
+
 Jid &Jid::parseFromString(const QString &AJidStr)
 {
-	if (!FJidCache.contains(AJidStr))
+	JidCacheShard &shard = JidCache[qHash(AJidStr) % JID_CACHE_SHARDS];
+
+	QMutexLocker locker(&shard.mutex);
+	if (!shard.lookup(AJidStr,*this))
 	{
+		// Parse without holding the lock, stringprep is expensive
+		locker.unlock();
+
 		if (d == NULL)
 			d = new JidData;
 		JidData *dd = d.data();
@@ -545,18 +635,17 @@ Jid &Jid::parseFromString(const QString &AJidStr)
 			dd->FResource = dd->FPrepResource = QStringRef(NULL,0,0);
 			dd->FNodeValid = dd->FDomainValid = dd->FResourceValid = false;
 		}
-		FJidCache.insert(AJidStr,*this);
-	}
-	else
-	{
-		*this = FJidCache.value(AJidStr);
+		dd->FHash = qHash(dd->FPrepFull);
+
+		locker.relock();
+		shard.insert(AJidStr,*this);
 	}
 	return *this;
 }
 
 uint qHash(const Jid &AKey)
 {
-	return qHash(AKey.pFull());
+	return AKey.d->FHash;
 }
 
 QDataStream &operator<<(QDataStream &AStream, const Jid &AJid)
@@ -9,6 +9,9 @@
 #include <QSharedData>
 #include "utilsexport.h"
 
+class Jid;
+UTILS_EXPORT uint qHash(const Jid &AKey);
+
 class JidData :
 	public QSharedData
 {
@@ -22,10 +25,12 @@ public:
 	QStringRef FDomain, FPrepDomain;
 	QStringRef FResource, FPrepResource;
 	bool FNodeValid, FDomainValid, FResourceValid;
+	uint FHash;
 };
 
 class UTILS_EXPORT Jid
 {
+	friend uint qHash(const Jid &AKey);
 public:
 	Jid(const char *AJidStr);
 	Jid(const QString &AJidStr=QString::null);
@@ -70,15 +75,16 @@ public:
 	static QString nodePrepare(const QString &ANode);
 	static QString domainPrepare(const QString &ADomain);
 	static QString resourcePrepare(const QString &AResource);
+public:
+	static int cacheSize();
+	static quint64 cacheHits();
+	static quint64 cacheMisses();
 protected:
 	Jid &parseFromString(const QString &AJidStr);
 private:
 	QSharedDataPointer<JidData> d;
-private:
-	static QHash<QString,Jid> FJidCache;
 };
 
-UTILS_EXPORT uint qHash(const Jid &AKey);
 UTILS_EXPORT QDataStream &operator>>(QDataStream &AStream, Jid &AJid);
 UTILS_EXPORT QDataStream &operator<<(QDataStream &AStream, const Jid &AJid);
 
@@ -2,12 +2,17 @@
 
 #include <QDir>
 #include <QFile>
+#include <QThread>
 #include <QtDebug>
 #include <QDateTime>
 #include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QWaitCondition>
 #include "datetime.h"
 
-#define MAX_LOG_FILES  10
+#define MAX_LOG_FILES           10
+#define DEFAULT_FLUSH_INTERVAL  100
+#define DEFAULT_MAX_FILE_SIZE   10*1024*1024
 
 void qtMessagesHandler(QtMsgType AType, const char *AMessage)
 {
@@ -28,17 +33,82 @@ void qtMessagesHandler(QtMsgType AType, const char *AMessage)
 	}
 }
 
+struct LogEntry {
+	LogEntry *next;
+	quint32 type;
+	qint64 time;
+	QString className;
+	QString message;
+};
+
+class LogWriter :
+	public QThread
+{
+public:
+	LogWriter() {
+		FQuit = false;
+	}
+	void startWriting() {
+		FQuit = false;
+		start(QThread::LowPriority);
+	}
+	void wakeUp() {
+		FWaitCondition.wakeAll();
+	}
+	void stopWriting() {
+		QMutexLocker locker(&FWaitMutex);
+		FQuit = true;
+		FWaitCondition.wakeAll();
+	}
+protected:
+	void run() {
+		QMutexLocker locker(&FWaitMutex);
+		while (!FQuit)
+		{
+			int interval = Logger::flushInterval();
+			FWaitCondition.wait(&FWaitMutex, interval>0 ? (unsigned long)interval : ULONG_MAX);
+			locker.unlock();
+			Logger::flushLog();
+			locker.relock();
+		}
+	}
+private:
+	bool FQuit;
+	QMutex FWaitMutex;
+	QWaitCondition FWaitCondition;
+};
+
 struct Logger::LoggerData {
+	bool opened;
 	QFile logFile;
+	QString logPath;
+	QStringList logFiles;
 	quint32 loggedTypes;
 	quint32 enabledTypes;
-	QMap<QString,QMap<QString,QDateTime> > timings;
+	int flushInterval;
+	qint64 maxFileSize;
+	qint64 lastLogTime;
+	LogWriter *writer;
+	LogEntry *pending;
+	QMutex pendingMutex;
+	QMutex timingMutex;
+	QElapsedTimer timingClock;
+	QMap<QString,QMap<QString,qint64> > timings;
 };
 
 QMutex Logger::FMutex;
 Logger::Logger()
 {
 	d = new LoggerData;
+	d->opened = false;
+	d->writer = NULL;
+	d->pending = NULL;
+	d->loggedTypes = 0;
+	d->enabledTypes = 0;
+	d->flushInterval = DEFAULT_FLUSH_INTERVAL;
+	d->maxFileSize = DEFAULT_MAX_FILE_SIZE;
+	d->lastLogTime = QDateTime::currentMSecsSinceEpoch();
+	d->timingClock.start();
 }
 
 Logger::~Logger()
@@ -54,6 +124,7 @@ Logger * Logger::instance()
 
 QString Logger::logFileName()
 {
+	QMutexLocker locker(&FMutex);
 	return instance()->d->logFile.fileName();
 }
 
@@ -63,32 +134,96 @@ void Logger::openLog(const QString &APath)
 	LoggerData *q = instance()->d;
 	if (!q->logFile.isOpen() && !APath.isEmpty())
 	{
-		QDir logDir(APath);
-		QStringList logFiles = logDir.entryList(QStringList()<<"*.log",QDir::Files,QDir::Name);
-		while (logFiles.count() > MAX_LOG_FILES)
-			QFile::remove(logDir.absoluteFilePath(logFiles.takeFirst()));
-
 #ifndef DEBUG_MODE
 		qInstallMsgHandler(qtMessagesHandler);
 #endif
-		q->logFile.setFileName(logDir.absoluteFilePath(DateTime(QDateTime::currentDateTime()).toX85DateTime().replace(":","-") +".log"));
-		q->logFile.open(QFile::WriteOnly|QFile::Truncate);
+		q->logPath = APath;
+		openLogFile();
+
+		if (q->logFile.isOpen())
+		{
+			q->pendingMutex.lock();
+			q->opened = true;
+			q->pendingMutex.unlock();
+
+			if (q->flushInterval > 0)
+			{
+				if (q->writer == NULL)
+					q->writer = new LogWriter;
+				q->writer->startWriting();
+			}
+		}
 	}
 }
 
 void Logger::closeLog(bool ARemove)
 {
 	LOG_INFO("Log closed");
-	QMutexLocker locker(&FMutex);
 	LoggerData *q = instance()->d;
+
+	// Entries are not accepted after this point, so all of them are written below
+	q->pendingMutex.lock();
+	q->opened = false;
+	q->pendingMutex.unlock();
+
+	// Writer is kept to be reused by the next openLog
+	if (q->writer != NULL)
+	{
+		q->writer->stopWriting();
+		q->writer->wait();
+	}
+	flushLog();
+
+	QMutexLocker locker(&FMutex);
 	if (q->logFile.isOpen())
 	{
 		q->logFile.close();
 		if (ARemove)
-			QFile::remove(q->logFile.fileName());
+		{
+			foreach(const QString &fileName, q->logFiles)
+				QFile::remove(fileName);
+		}
+	}
+	q->logFiles.clear();
+}
+
+int Logger::flushInterval()
+{
+	return instance()->d->flushInterval;
+}
+
+void Logger::setFlushInterval(int AInterval)
+{
+	QMutexLocker locker(&FMutex);
+	LoggerData *q = instance()->d;
+	q->flushInterval = AInterval;
+
+	q->pendingMutex.lock();
+	bool opened = q->opened;
+	q->pendingMutex.unlock();
+
+	if (q->flushInterval>0 && opened)
+	{
+		if (q->writer == NULL)
+			q->writer = new LogWriter;
+		if (!q->writer->isRunning())
+			q->writer->startWriting();
+		else
+			q->writer->wakeUp();
 	}
 }
 
+qint64 Logger::maxFileSize()
+{
+	return instance()->d->maxFileSize;
+}
+
+void Logger::setMaxFileSize(qint64 ASize)
+{
+	QMutexLocker locker(&FMutex);
+	instance()->d->maxFileSize = ASize;
+}
+
 quint32 Logger::loggedTypes()
 {
 	return instance()->d->loggedTypes;
@@ -107,16 +242,119 @@ void Logger::setEnabledTypes(quint32 ATypes)
 
 void Logger::writeLog(quint32 AType, const QString &AClass, const QString &AMessage)
 {
-	QMutexLocker locker(&FMutex);
 	LoggerData *q = instance()->d;
-	if ((q->enabledTypes & AType)>0 && q->logFile.isOpen())
+	if ((q->enabledTypes & AType) > 0)
 	{
-		static QDateTime lastLogTime = QDateTime::currentDateTime();
+		LogEntry *entry = new LogEntry;
+		entry->type = AType;
+		entry->time = QDateTime::currentMSecsSinceEpoch();
+		entry->className = AClass;
+		entry->message = AMessage;
+
+		// Opened state is checked under the same lock to not lose entries on close
+		q->pendingMutex.lock();
+		bool opened = q->opened;
+		if (opened)
+		{
+			entry->next = q->pending;
+			q->pending = entry;
+		}
+		q->pendingMutex.unlock();
+
+		// Fatal messages are written before the application is aborted
+		if (!opened)
+			delete entry;
+		else if (AType==Logger::Fatal || q->flushInterval<=0)
+			flushLog();
+		else if (AType==Logger::Error && q->writer!=NULL)
+			q->writer->wakeUp();
+	}
+}
+
+QString Logger::startTiming(const QString &AVariable, const QString &AContext)
+{
+	if (!AVariable.isEmpty())
+	{
+		LoggerData *q = instance()->d;
+		QMutexLocker locker(&q->timingMutex);
+		q->timings[AVariable][AContext] = q->timingClock.elapsed();
+	}
+	return AContext;
+}
+
+qint64 Logger::checkTiming( const QString &AVariable, const QString &AContext)
+{
+	LoggerData *q = instance()->d;
+	QMutexLocker locker(&q->timingMutex);
+	qint64 startTime = q->timings.value(AVariable).value(AContext,-1);
+	return startTime>=0 ? q->timingClock.elapsed()-startTime : -1;
+}
+
+qint64 Logger::finishTiming(const QString &AVariable, const QString &AContext)
+{
+	qint64 timing = -1;
+
+	LoggerData *q = instance()->d;
+	QMutexLocker locker(&q->timingMutex);
+
+	QMap<QString, qint64> &varMap = q->timings[AVariable];
+		
+	qint64 startTime = varMap.value(AContext,-1);
+	varMap.remove(AContext);
+	if (startTime >= 0)
+		timing = q->timingClock.elapsed()-startTime;
+
+	if (varMap.isEmpty())
+		q->timings.remove(AVariable);
+
+	return timing;
+}
+
+void Logger::openLogFile()
+{
+	LoggerData *q = instance()->d;
+	if (q->logFile.isOpen())
+		q->logFile.close();
+
+	QDir logDir(q->logPath);
+	QStringList logFiles = logDir.entryList(QStringList()<<"*.log",QDir::Files,QDir::Name);
+	while (logFiles.count() > MAX_LOG_FILES)
+		QFile::remove(logDir.absoluteFilePath(logFiles.takeFirst()));
+
+	QString fileName = DateTime(QDateTime::currentDateTime()).toX85DateTime().replace(":","-");
+	QString filePath = logDir.absoluteFilePath(fileName+".log");
+	for (int index=1; QFile::exists(filePath); index++)
+		filePath = logDir.absoluteFilePath(QString("%1_%2.log").arg(fileName).arg(index));
+
+	q->logFile.setFileName(filePath);
+	if (q->logFile.open(QFile::WriteOnly|QFile::Truncate))
+		q->logFiles.append(filePath);
+}
+
+void Logger::flushLog()
+{
+	QMutexLocker locker(&FMutex);
+	LoggerData *q = instance()->d;
 
-		QDateTime curDateTime = QDateTime::currentDateTime();
+	// Pending entries are stacked in reverse order
+	LogEntry *entry = NULL;
+	q->pendingMutex.lock();
+	LogEntry *stacked = q->pending;
+	q->pending = NULL;
+	q->pendingMutex.unlock();
+	while (stacked != NULL)
+	{
+		LogEntry *next = stacked->next;
+		stacked->next = entry;
+		entry = stacked;
+		stacked = next;
+	}
 
+	QByteArray logData;
+	while (entry != NULL)
+	{
 		QString typeName;
-		switch(AType)
+		switch(entry->type)
 		{
 		case Logger::Fatal:
 			typeName = "!FTL";
@@ -146,60 +384,35 @@ void Logger::writeLog(quint32 AType, const QString &AClass, const QString &AMess
 			typeName = " STZ";
 			break;
 		default:
-			typeName = QString(" T%1").arg(AType);
+			typeName = QString(" T%1").arg(entry->type);
 		}
 
-		QString timestamp = curDateTime.toString("hh:mm:ss.zzz");
-		int timeDelta = lastLogTime.msecsTo(curDateTime);
-		QString logLine = QString("%1\t+%2\t%3\t[%4] %5").arg(timestamp).arg(timeDelta).arg(typeName,AClass,AMessage);
-		q->logFile.write(logLine.toUtf8());
-		q->logFile.write("\r\n");
-		q->logFile.flush();
+		QString timestamp = QDateTime::fromMSecsSinceEpoch(entry->time).toString("hh:mm:ss.zzz");
+		qint64 timeDelta = qMax(entry->time-q->lastLogTime,(qint64)0);
+		QString logLine = QString("%1\t+%2\t%3\t[%4] %5").arg(timestamp).arg(timeDelta).arg(typeName,entry->className,entry->message);
+		logData += logLine.toUtf8();
+		logData += "\r\n";
 
 #if defined(DEBUG_MODE)
-		if (AType <= Logger::Warning)
+		if (entry->type <= Logger::Warning)
 			qDebug() << logLine;
 #endif
 
-		q->loggedTypes |= AType;
-		lastLogTime = curDateTime;
+		q->loggedTypes |= entry->type;
+		q->lastLogTime = entry->time;
+
+		LogEntry *next = entry->next;
+		delete entry;
+		entry = next;
 	}
-}
 
-QString Logger::startTiming(const QString &AVariable, const QString &AContext)
-{
-	if (!AVariable.isEmpty())
+	if (!logData.isEmpty() && q->logFile.isOpen())
 	{
-		QMutexLocker locker(&FMutex);
-		instance()->d->timings[AVariable][AContext] = QDateTime::currentDateTime();
+		if (q->maxFileSize>0 && q->logFile.size()>0 && q->logFile.size()+logData.size()>q->maxFileSize)
+			openLogFile();
+		q->logFile.write(logData);
+		q->logFile.flush();
 	}
-	return AContext;
-}
-
-qint64 Logger::checkTiming( const QString &AVariable, const QString &AContext)
-{
-	QMutexLocker locker(&FMutex);
-	QDateTime startTime = instance()->d->timings.value(AVariable).value(AContext);
-	return startTime.isValid() ? startTime.msecsTo(QDateTime::currentDateTime()) : -1;
-}
-
-qint64 Logger::finishTiming(const QString &AVariable, const QString &AContext)
-{
-	qint64 timing = -1;
-
-	QMutexLocker locker(&FMutex);
-	LoggerData *q = instance()->d;
-
-	QMap<QString, QDateTime> &varMap = q->timings[AVariable];
-		
-	QDateTime startTime = varMap.take(AContext);
-	if (startTime.isValid())
-		timing = startTime.msecsTo(QDateTime::currentDateTime());
-
-	if (varMap.isEmpty())
-		q->timings.remove(AVariable);
-
-	return timing;
 }
 
 void Logger::reportView(const QString &AClass)
@@ -10,6 +10,7 @@ class UTILS_EXPORT Logger :
 	public QObject
 {
 	Q_OBJECT;
+	friend class LogWriter;
 	struct LoggerData;
 public:
 	enum LogType {
@@ -28,6 +29,10 @@ public:
 	static QString logFileName();
 	static void openLog(const QString &APath);
 	static void closeLog(bool ARemove = false);
+	static int flushInterval();
+	static void setFlushInterval(int AInterval);
+	static qint64 maxFileSize();
+	static void setMaxFileSize(qint64 ASize);
 public:
 	static quint32 loggedTypes();
 	static quint32 enabledTypes();
@@ -47,6 +52,9 @@ signals:
 	void errorReported(const QString &AClass, const QString &AMessage, bool AFatal);
 	void eventReported(const QString &AClass, const QString &ACategory, const QString &AAction, const QString &ALabel, qint64 AValue);
 	void timingReported(const QString &AClass, const QString &ACategory, const QString &AVariable, const QString &ALabel, qint64 ATime);
+protected:
+	static void openLogFile();
+	static void flushLog();
 private:
 	Logger();
 	~Logger();
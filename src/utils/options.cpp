@@ -2,6 +2,8 @@
 
 #include <QFile>
 #include <QRect>
+#include <QThread>
+#include <QCoreApplication>
 #include <QDataStream>
 #include <QStringList>
 #include <QKeySequence>
@@ -460,6 +462,48 @@ OptionsNode &OptionsNode::operator=(const OptionsNode &AOther)
 	return *this;
 }
 
+//OptionsValue
+struct OptionsValue::OptionsValueData
+{
+	bool valid;
+	QString path;
+	QVariant value;
+};
+
+OptionsValue::OptionsValue(const QString &APath, const QString &ANSpace)
+{
+	// Cache and options document are not locked, so handles are GUI thread only
+	Q_ASSERT(QThread::currentThread() == qApp->thread());
+
+	// Path must be the same as OptionsNode::path() to be invalidated on changes
+	QString path = !ANSpace.isEmpty() ? APath + NsOpenChar + ANSpace + NsCloseChar : APath;
+
+	OptionsValueData *&data = Options::instance()->d->values[path];
+	if (data == NULL)
+	{
+		data = new OptionsValueData;
+		data->valid = false;
+		data->path = path;
+	}
+	d = data;
+}
+
+QString OptionsValue::path() const
+{
+	return d->path;
+}
+
+QVariant OptionsValue::value() const
+{
+	Q_ASSERT(QThread::currentThread() == qApp->thread());
+	if (!d->valid)
+	{
+		d->value = Options::node(d->path).value();
+		d->valid = true;
+	}
+	return d->value;
+}
+
 //Options
 struct OptionItem
 {
@@ -473,15 +517,24 @@ struct Options::OptionsData
 	QDomDocument options;
 	QHash<QString, OptionItem> items;
 	QHash<QString, QString> cleanPathCache;
+	QHash<QString, OptionsValue::OptionsValueData *> values;
 };
 
 Options::Options()
 {
 	d = new OptionsData;
+
+	// Connected first to invalidate cached values before other receivers are notified
+	connect(this,SIGNAL(optionsOpened()),SLOT(onOptionsReset()));
+	connect(this,SIGNAL(optionsClosed()),SLOT(onOptionsReset()));
+	connect(this,SIGNAL(optionsChanged(const OptionsNode &)),SLOT(onOptionsChanged(const OptionsNode &)));
+	connect(this,SIGNAL(optionsRemoved(const OptionsNode &)),SLOT(onOptionsReset()));
+	connect(this,SIGNAL(defaultValueChanged(const QString &, const QVariant &)),SLOT(onOptionsReset()));
 }
 
 Options::~Options()
 {
+	qDeleteAll(d->values);
 	delete d;
 }
 
@@ -786,3 +839,30 @@ OptionsNode Options::createNodeForElement(const QDomElement &AElement)
 {
 	return OptionsNode(AElement);
 }
+
+void Options::invalidateValues()
+{
+	for (QHash<QString, OptionsValue::OptionsValueData *>::iterator it=d->values.begin(); it!=d->values.end(); ++it)
+		it.value()->valid = false;
+}
+
+void Options::onOptionsChanged(const OptionsNode &ANode)
+{
+	// Invalidate changed node, its ancestors and its descendants
+	QString path = ANode.path();
+	for (QHash<QString, OptionsValue::OptionsValueData *>::iterator it=d->values.begin(); it!=d->values.end(); ++it)
+	{
+		const QString &valuePath = it.key();
+		if (valuePath == path)
+			it.value()->valid = false;
+		else if (valuePath.length()>path.length() && valuePath.startsWith(path) && valuePath.at(path.length())==DelimChar)
+			it.value()->valid = false;
+		else if (path.length()>valuePath.length() && path.startsWith(valuePath) && path.at(valuePath.length())==DelimChar)
+			it.value()->valid = false;
+	}
+}
+
+void Options::onOptionsReset()
+{
+	invalidateValues();
+}
@@ -44,11 +44,25 @@ private:
 	OptionsNodeData *d;
 };
 
+// Cached option value handle, must be used from the GUI thread only
+class UTILS_EXPORT OptionsValue
+{
+	friend class Options;
+	struct OptionsValueData;
+public:
+	OptionsValue(const QString &APath, const QString &ANSpace = QString::null);
+	QString path() const;
+	QVariant value() const;
+private:
+	OptionsValueData *d;
+};
+
 class UTILS_EXPORT Options :
 	public QObject
 {
 	Q_OBJECT;
 	friend class OptionsNode;
+	friend class OptionsValue;
 	struct OptionsData;
 public:
 	static Options *instance();
@@ -78,6 +92,11 @@ signals:
 	void optionsChanged(const OptionsNode &ANode);
 	void optionsRemoved(const OptionsNode &ANode);
 	void defaultValueChanged(const QString &APath, const QVariant &ADefault);
+protected:
+	void invalidateValues();
+protected slots:
+	void onOptionsChanged(const OptionsNode &ANode);
+	void onOptionsReset();
 private:
 	Options();
 	~Options();
@@ -21,6 +21,11 @@ int RingBuffer::maximumSize() const
 	return maxBufferSize;
 }
 
+void RingBuffer::setMaximumSize(int maxSize)
+{
+	maxBufferSize = maxSize;
+}
+
 void RingBuffer::clear()
 {
 	if (!buffers.isEmpty()) {
@@ -51,6 +51,7 @@ public:
 	bool isEmpty() const;
 	int size() const;
 	int maximumSize() const;
+	void setMaximumSize(int maxSize);
 	void clear();
 	void truncate(int pos);
 	void chop(int bytes);
@@ -61,12 +62,12 @@ public:
 	int read(char *data, int maxLength);
 	bool canReadLine() const;
 	int readLine(char *data, int maxLength);
-private:
-	void free(int bytes);
 	char *reserve(int bytes);
-	int indexOf(char c) const;
 	int nextDataBlockSize() const;
 	const char *readPointer() const;
+private:
+	void free(int bytes);
+	int indexOf(char c) const;
 	QByteArray peek(int maxLength) const;
 private:
 	int head, tail;
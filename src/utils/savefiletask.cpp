@@ -0,0 +1,85 @@
+#include "savefiletask.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include "logger.h"
+
+#ifdef Q_OS_WIN32
+#	include <windows.h>
+#else
+#	include <stdio.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+#define TEMP_FILE_SUFFIX    ".tmp"
+
+SaveFileTask::SaveFileTask(const QString &AFileName, const QByteArray &AData) : QRunnable()
+{
+	FFileName = AFileName;
+	FData = AData;
+}
+
+void SaveFileTask::run()
+{
+	saveFile(FFileName,FData);
+}
+
+bool SaveFileTask::saveFile(const QString &AFileName, const QByteArray &AData)
+{
+	// Data is written to temporary file and synced to disk before it replaces the file,
+	// so that previous file content is kept if process is killed or power is lost
+	QFile file(AFileName + TEMP_FILE_SUFFIX);
+	if (file.open(QIODevice::WriteOnly|QIODevice::Truncate))
+	{
+		bool written = file.write(AData)==AData.size() && file.flush();
+#ifndef Q_OS_WIN32
+		written = written && ::fsync(file.handle())==0;
+#endif
+		file.close();
+
+#ifdef Q_OS_WIN32
+		if (written)
+		{
+			HANDLE handle = CreateFileW((LPCWSTR)QDir::toNativeSeparators(file.fileName()).utf16(),GENERIC_WRITE,0,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+			written = handle!=INVALID_HANDLE_VALUE && FlushFileBuffers(handle)!=0;
+			if (handle != INVALID_HANDLE_VALUE)
+				CloseHandle(handle);
+		}
+#endif
+
+		if (written)
+		{
+#ifdef Q_OS_WIN32
+			bool replaced = MoveFileExW((LPCWSTR)QDir::toNativeSeparators(file.fileName()).utf16(),(LPCWSTR)QDir::toNativeSeparators(AFileName).utf16(),MOVEFILE_REPLACE_EXISTING|MOVEFILE_WRITE_THROUGH)!=0;
+#else
+			bool replaced = ::rename(QFile::encodeName(file.fileName()).constData(),QFile::encodeName(AFileName).constData())==0;
+			if (replaced)
+			{
+				// Directory entry of renamed file should be synced too
+				int dirHandle = ::open(QFile::encodeName(QFileInfo(AFileName).absolutePath()).constData(),O_RDONLY);
+				if (dirHandle >= 0)
+				{
+					::fsync(dirHandle);
+					::close(dirHandle);
+				}
+			}
+#endif
+			if (replaced)
+				return true;
+			else
+				Logger::reportError("SaveFileTask",QString("Failed to replace file with saved data: %1").arg(qt_error_string()),false);
+		}
+		else
+		{
+			Logger::reportError("SaveFileTask",QString("Failed to write data to temporary file: %1").arg(file.error()!=QFile::NoError ? file.errorString() : qt_error_string()),false);
+		}
+		file.remove();
+	}
+	else
+	{
+		Logger::reportError("SaveFileTask",QString("Failed to create temporary file: %1").arg(file.errorString()),false);
+	}
+	return false;
+}
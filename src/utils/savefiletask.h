@@ -0,0 +1,22 @@
+#ifndef SAVEFILETASK_H
+#define SAVEFILETASK_H
+
+#include <QString>
+#include <QRunnable>
+#include <QByteArray>
+#include "utilsexport.h"
+
+class UTILS_EXPORT SaveFileTask :
+	public QRunnable
+{
+public:
+	SaveFileTask(const QString &AFileName, const QByteArray &AData);
+	virtual void run();
+public:
+	static bool saveFile(const QString &AFileName, const QByteArray &AData);
+private:
+	QString FFileName;
+	QByteArray FData;
+};
+
+#endif // SAVEFILETASK_H
@@ -15,9 +15,283 @@ static inline bool IsValidXmlChar(quint32 ACode)
 }
 
 
+StanzaTree::StanzaTree()
+{
+
+}
+
+bool StanzaTree::isEmpty() const
+{
+	return FNodes.isEmpty();
+}
+
+void StanzaTree::clear()
+{
+	FArena.clear();
+	FAttrs.clear();
+	FNodes.clear();
+}
+
+int StanzaTree::appendElement(int AParent, const QStringRef &ANamespace, const QStringRef &AName)
+{
+	Node node;
+	node.type = ElementNode;
+	node.parent = AParent;
+	node.next = -1;
+	node.firstChild = -1;
+	node.lastChild = -1;
+	node.firstAttr = -1;
+	node.lastAttr = -1;
+	node.ns = appendRef(ANamespace);
+	node.name = appendRef(AName);
+	node.local = appendLocalRef(node.name);
+	node.value = appendRef(QStringRef());
+
+	int index = FNodes.count();
+	FNodes.append(node);
+
+	if (AParent>=0 && AParent<index)
+	{
+		Node &parent = FNodes[AParent];
+		if (parent.lastChild >= 0)
+			FNodes[parent.lastChild].next = index;
+		else
+			parent.firstChild = index;
+		parent.lastChild = index;
+	}
+
+	return index;
+}
+
+void StanzaTree::appendAttribute(int AElem, const QStringRef &ANamespace, const QStringRef &AName, const QStringRef &AValue)
+{
+	if (AElem>=0 && AElem<FNodes.count() && FNodes.at(AElem).type==ElementNode)
+	{
+		Attr attr;
+		attr.next = -1;
+		attr.ns = appendRef(ANamespace);
+		attr.name = appendRef(AName);
+		attr.value = appendRef(AValue);
+
+		int index = FAttrs.count();
+		FAttrs.append(attr);
+
+		Node &elem = FNodes[AElem];
+		if (elem.lastAttr >= 0)
+			FAttrs[elem.lastAttr].next = index;
+		else
+			elem.firstAttr = index;
+		elem.lastAttr = index;
+	}
+}
+
+void StanzaTree::appendText(int AParent, const QStringRef &AText, bool ACData)
+{
+	if (AParent>=0 && AParent<FNodes.count() && FNodes.at(AParent).type==ElementNode)
+	{
+		int type = ACData ? CDataNode : TextNode;
+		int lastChild = FNodes.at(AParent).lastChild;
+
+		// Text split by network chunks is merged into the previous node while it is still at the end of arena
+		Node *last = lastChild>=0 ? &FNodes[lastChild] : NULL;
+		if (last!=NULL && last->type==type && last->value.pos+last->value.len==FArena.size())
+		{
+			FArena.append(AText);
+			last->value.len += AText.size();
+		}
+		else
+		{
+			Node node;
+			node.type = type;
+			node.parent = AParent;
+			node.next = -1;
+			node.firstChild = -1;
+			node.lastChild = -1;
+			node.firstAttr = -1;
+			node.lastAttr = -1;
+			node.ns = node.name = node.local = appendRef(QStringRef());
+			node.value = appendRef(AText);
+
+			int index = FNodes.count();
+			FNodes.append(node);
+
+			Node &parent = FNodes[AParent];
+			if (parent.lastChild >= 0)
+				FNodes[parent.lastChild].next = index;
+			else
+				parent.firstChild = index;
+			parent.lastChild = index;
+		}
+	}
+}
+
+int StanzaTree::parentNode(int ANode) const
+{
+	return ANode>=0 && ANode<FNodes.count() ? FNodes.at(ANode).parent : -1;
+}
+
+bool StanzaTree::hasChildNodes(int ANode) const
+{
+	return ANode>=0 && ANode<FNodes.count() ? FNodes.at(ANode).firstChild>=0 : false;
+}
+
+int StanzaTree::firstChildElement(int ANode, const QString &ATagName) const
+{
+	int child = ANode>=0 && ANode<FNodes.count() ? FNodes.at(ANode).firstChild : -1;
+	while (child>=0 && (FNodes.at(child).type!=ElementNode || (!ATagName.isEmpty() && stringRef(FNodes.at(child).local)!=ATagName)))
+		child = FNodes.at(child).next;
+	return child;
+}
+
+int StanzaTree::nextSiblingElement(int ANode, const QString &ATagName) const
+{
+	int sibling = ANode>=0 && ANode<FNodes.count() ? FNodes.at(ANode).next : -1;
+	while (sibling>=0 && (FNodes.at(sibling).type!=ElementNode || (!ATagName.isEmpty() && stringRef(FNodes.at(sibling).local)!=ATagName)))
+		sibling = FNodes.at(sibling).next;
+	return sibling;
+}
+
+QString StanzaTree::tagName(int ANode) const
+{
+	return ANode>=0 && ANode<FNodes.count() ? stringRef(FNodes.at(ANode).local).toString() : QString::null;
+}
+
+QString StanzaTree::namespaceURI(int ANode) const
+{
+	return ANode>=0 && ANode<FNodes.count() ? stringRef(FNodes.at(ANode).ns).toString() : QString::null;
+}
+
+bool StanzaTree::hasAttribute(int AElem, const QString &AName) const
+{
+	return findAttribute(AElem,AName) >= 0;
+}
+
+QString StanzaTree::attribute(int AElem, const QString &AName, const QString &ADefault) const
+{
+	int attr = findAttribute(AElem,AName);
+	return attr>=0 ? stringRef(FAttrs.at(attr).value).toString() : ADefault;
+}
+
+void StanzaTree::setAttribute(int AElem, const QString &AName, const QString &AValue)
+{
+	int attr = findAttribute(AElem,AName);
+	if (attr >= 0)
+		FAttrs[attr].value = appendRef(QStringRef(&AValue));
+	else
+		appendAttribute(AElem,QStringRef(),QStringRef(&AName),QStringRef(&AValue));
+}
+
+void StanzaTree::removeAttribute(int AElem, const QString &AName)
+{
+	int attr = findAttribute(AElem,AName);
+	if (attr >= 0)
+	{
+		Node &elem = FNodes[AElem];
+		if (elem.firstAttr != attr)
+		{
+			int prev = elem.firstAttr;
+			while (FAttrs.at(prev).next != attr)
+				prev = FAttrs.at(prev).next;
+			FAttrs[prev].next = FAttrs.at(attr).next;
+			if (elem.lastAttr == attr)
+				elem.lastAttr = prev;
+		}
+		else
+		{
+			elem.firstAttr = FAttrs.at(attr).next;
+			if (elem.lastAttr == attr)
+				elem.lastAttr = -1;
+		}
+	}
+}
+
+QDomElement StanzaTree::toElement(QDomDocument &ADoc, int AElem) const
+{
+	QDomElement elem;
+	if (AElem>=0 && AElem<FNodes.count() && FNodes.at(AElem).type==ElementNode)
+	{
+		const Node &node = FNodes.at(AElem);
+		elem = ADoc.createElementNS(stringRef(node.ns).toString(),stringRef(node.name).toString());
+
+		for (int attr=node.firstAttr; attr>=0; attr=FAttrs.at(attr).next)
+		{
+			const Attr &nodeAttr = FAttrs.at(attr);
+			if (nodeAttr.ns.len > 0)
+				elem.setAttributeNS(stringRef(nodeAttr.ns).toString(),stringRef(nodeAttr.name).toString(),stringRef(nodeAttr.value).toString());
+			else
+				elem.setAttribute(stringRef(nodeAttr.name).toString(),stringRef(nodeAttr.value).toString());
+		}
+
+		for (int child=node.firstChild; child>=0; child=FNodes.at(child).next)
+		{
+			const Node &childNode = FNodes.at(child);
+			if (childNode.type == ElementNode)
+				elem.appendChild(toElement(ADoc,child));
+			else if (childNode.type == CDataNode)
+				elem.appendChild(ADoc.createCDATASection(stringRef(childNode.value).toString()));
+			else
+				elem.appendChild(ADoc.createTextNode(stringRef(childNode.value).toString()));
+		}
+	}
+	return elem;
+}
+
+StanzaTree::Ref StanzaTree::appendRef(const QStringRef &AString)
+{
+	Ref ref;
+	ref.pos = FArena.size();
+	ref.len = AString.size();
+	if (ref.len > 0)
+		FArena.append(AString);
+	return ref;
+}
+
+StanzaTree::Ref StanzaTree::appendLocalRef(const Ref &AName) const
+{
+	Ref local = AName;
+	const QChar *data = FArena.constData() + AName.pos;
+	for (int i=0; i<AName.len; i++)
+	{
+		if (data[i] == ':')
+		{
+			local.pos = AName.pos + i + 1;
+			local.len = AName.len - i - 1;
+			break;
+		}
+	}
+	return local;
+}
+
+QStringRef StanzaTree::stringRef(const Ref &ARef) const
+{
+	return QStringRef(&FArena,ARef.pos,ARef.len);
+}
+
+int StanzaTree::findAttribute(int AElem, const QString &AName) const
+{
+	if (AElem>=0 && AElem<FNodes.count())
+	{
+		for (int attr=FNodes.at(AElem).firstAttr; attr>=0; attr=FAttrs.at(attr).next)
+		{
+			const Attr &nodeAttr = FAttrs.at(attr);
+			if (stringRef(nodeAttr.name)==AName)
+				return attr;
+		}
+	}
+	return -1;
+}
+
+
 StanzaData::StanzaData(const StanzaData &AOther) : QSharedData(AOther)
 {
-	FDoc = AOther.FDoc.cloneNode(true).toDocument();
+	FTree = AOther.FTree;
+	if (FTree.isEmpty())
+		FDoc = AOther.FDoc.cloneNode(true).toDocument();
+}
+
+StanzaData::StanzaData(const StanzaTree &ATree)
+{
+	FTree = ATree;
 }
 
 StanzaData::StanzaData(const QDomElement &AElem)
@@ -30,12 +304,26 @@ StanzaData::StanzaData(const QString &AKind, const QString &ANamespace)
 	FDoc.appendChild(FDoc.createElementNS(ANamespace,AKind));
 }
 
+void StanzaData::materialize() const
+{
+	if (!FTree.isEmpty())
+	{
+		FDoc.appendChild(FTree.toElement(FDoc));
+		FTree.clear();
+	}
+}
+
 
 Stanza::Stanza(const QDomElement &AElem)
 {
 	d = new StanzaData(AElem);
 }
 
+Stanza::Stanza(const StanzaTree &ATree)
+{
+	d = new StanzaData(ATree);
+}
+
 Stanza::Stanza(const QString &AKind, const QString &ANamespace)
 {
 	d = new StanzaData(AKind, ANamespace);
@@ -48,7 +336,7 @@ void Stanza::detach()
 
 bool Stanza::isNull() const
 {
-	return element().isNull();
+	return d->FTree.isEmpty() ? d->FDoc.documentElement().isNull() : false;
 }
 
 bool Stanza::isResult() const
@@ -68,26 +356,38 @@ bool Stanza::isFromServer() const
 
 QDomDocument Stanza::document() const
 {
+	d->materialize();
 	return d->FDoc;
 }
 
 QDomElement Stanza::element() const
 {
+	d->materialize();
 	return d->FDoc.documentElement();
 }
 
+const StanzaTree &Stanza::tree() const
+{
+	return d->FTree;
+}
+
 QString Stanza::namespaceURI() const
 {
+	if (!d->FTree.isEmpty())
+		return d->FTree.namespaceURI(0);
 	return d->FDoc.documentElement().namespaceURI();
 }
 
 QString Stanza::kind() const
 {
+	if (!d->FTree.isEmpty())
+		return d->FTree.tagName(0);
 	return d->FDoc.documentElement().tagName();
 }
 
 Stanza &Stanza::setKind(const QString &AName)
 {
+	d->materialize();
 	d->FDoc.documentElement().setTagName(AName);
 	return *this;
 }
@@ -166,17 +466,28 @@ Stanza &Stanza::setLang(const QString &ALang)
 
 bool Stanza::hasAttribute(const QString &AName) const
 {
+	if (!d->FTree.isEmpty())
+		return d->FTree.hasAttribute(0,AName);
 	return d->FDoc.documentElement().hasAttribute(AName);
 }
 
 QString Stanza::attribute(const QString &AName, const QString &ADefault) const
 {
+	if (!d->FTree.isEmpty())
+		return d->FTree.attribute(0,AName,ADefault);
 	return d->FDoc.documentElement().attribute(AName,ADefault);
 }
 
 Stanza &Stanza::setAttribute(const QString &AName, const QString &AValue)
 {
-	if (!AValue.isEmpty())
+	if (!d->FTree.isEmpty())
+	{
+		if (!AValue.isEmpty())
+			d->FTree.setAttribute(0,AName,AValue);
+		else
+			d->FTree.removeAttribute(0,AName);
+	}
+	else if (!AValue.isEmpty())
 		d->FDoc.documentElement().setAttribute(AName,AValue);
 	else
 		d->FDoc.documentElement().removeAttribute(AName);
@@ -185,21 +496,24 @@ Stanza &Stanza::setAttribute(const QString &AName, const QString &AValue)
 
 QDomElement Stanza::firstElement(const QString &ATagName, const QString &ANamespace) const
 {
-	return findElement(d->FDoc.documentElement(),ATagName,ANamespace);
+	return findElement(element(),ATagName,ANamespace);
 }
 
 QDomElement Stanza::addElement(const QString &AName, const QString &ANamespace)
 {
+	d->materialize();
 	return d->FDoc.documentElement().appendChild(createElement(AName,ANamespace)).toElement();
 }
 
 QDomElement Stanza::createElement(const QString &AName, const QString &ANamespace)
 {
+	d->materialize();
 	return ANamespace.isEmpty() ? d->FDoc.createElement(AName) : d->FDoc.createElementNS(ANamespace,AName);
 }
 
 QDomText Stanza::createTextNode(const QString &AData)
 {
+	d->materialize();
 	return d->FDoc.createTextNode(AData);
 }
 
@@ -1,7 +1,9 @@
 #ifndef STANZA_H
 #define STANZA_H
 
+#include <QVector>
 #include <QMetaType>
+#include <QStringRef>
 #include <QSharedData>
 #include <QDomDocument>
 #include "jid.h"
@@ -18,21 +20,85 @@
 #define STANZA_TYPE_RESULT    "result"
 #define STANZA_TYPE_ERROR     "error"
 
+class UTILS_EXPORT StanzaTree
+{
+	struct Ref {
+		int pos;
+		int len;
+	};
+	struct Attr {
+		int next;
+		Ref ns;
+		Ref name;
+		Ref value;
+	};
+	struct Node {
+		int type;
+		int parent;
+		int next;
+		int firstChild;
+		int lastChild;
+		int firstAttr;
+		int lastAttr;
+		Ref ns;
+		Ref name;
+		Ref local;
+		Ref value;
+	};
+public:
+	enum NodeType {
+		ElementNode,
+		TextNode,
+		CDataNode
+	};
+public:
+	StanzaTree();
+	bool isEmpty() const;
+	void clear();
+	int appendElement(int AParent, const QStringRef &ANamespace, const QStringRef &AName);
+	void appendAttribute(int AElem, const QStringRef &ANamespace, const QStringRef &AName, const QStringRef &AValue);
+	void appendText(int AParent, const QStringRef &AText, bool ACData = false);
+	int parentNode(int ANode) const;
+	bool hasChildNodes(int ANode) const;
+	int firstChildElement(int ANode, const QString &ATagName = QString::null) const;
+	int nextSiblingElement(int ANode, const QString &ATagName = QString::null) const;
+	QString tagName(int ANode) const;
+	QString namespaceURI(int ANode) const;
+	bool hasAttribute(int AElem, const QString &AName) const;
+	QString attribute(int AElem, const QString &AName, const QString &ADefault = QString::null) const;
+	void setAttribute(int AElem, const QString &AName, const QString &AValue);
+	void removeAttribute(int AElem, const QString &AName);
+	QDomElement toElement(QDomDocument &ADoc, int AElem = 0) const;
+protected:
+	Ref appendRef(const QStringRef &AString);
+	Ref appendLocalRef(const Ref &AName) const;
+	QStringRef stringRef(const Ref &ARef) const;
+	int findAttribute(int AElem, const QString &AName) const;
+private:
+	QString FArena;
+	QVector<Attr> FAttrs;
+	QVector<Node> FNodes;
+};
+
 class StanzaData :
 	public QSharedData
 {
 public:
 	StanzaData(const StanzaData &AOther);
+	StanzaData(const StanzaTree &ATree);
 	StanzaData(const QDomElement &AElem);
 	StanzaData(const QString &AKind, const QString &ANamespace);
+	void materialize() const;
 public:
-	QDomDocument FDoc;
+	mutable QDomDocument FDoc;
+	mutable StanzaTree FTree;
 };
 
 class UTILS_EXPORT Stanza
 {
 public:
 	Stanza(const QDomElement &AElem);
+	Stanza(const StanzaTree &ATree);
 	Stanza(const QString &AKind=STANZA_KIND_MESSAGE, const QString &ANamespace=STANZA_NS_CLIENT);
 	void detach();
 	bool isNull() const;
@@ -41,6 +107,7 @@ public:
 	bool isFromServer() const;
 	QDomDocument document() const;
 	QDomElement element() const;
+	const StanzaTree &tree() const;
 	QString namespaceURI() const;
 	QString kind() const;
 	Stanza &setKind(const QString &AName);
@@ -32,7 +32,8 @@ HEADERS  = utilsexport.h \
            splitterwidget.h \
            logger.h \
            pluginhelper.h \
-           passworddialog.h
+           passworddialog.h \
+           savefiletask.h
 
 SOURCES  = jid.cpp \
            versionparser.cpp \
@@ -67,4 +68,5 @@ SOURCES  = jid.cpp \
            splitterwidget.cpp \
            logger.cpp \
            pluginhelper.cpp \
-           passworddialog.cpp
+           passworddialog.cpp \
+           savefiletask.cpp